@@ -0,0 +1,137 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "acpi.h"
+
+/* --- Structures ACPI (format impose par la spec) --- */
+typedef struct {
+    char signature[8];       // "RSD PTR "
+    uint8_t checksum;        // sur les 20 premiers octets
+    char oem_id[6];
+    uint8_t revision;        // 0 : ACPI 1.0 (RSDT seule), 2 : champs suivants valides
+    uint32_t rsdt_address;
+    uint32_t length;         // ACPI 2.0+
+    uint64_t xsdt_address;
+    uint8_t extended_checksum;
+    uint8_t reserved[3];
+} __attribute__((packed)) AcpiRsdp;
+
+/* En-tete commun a toutes les tables */
+typedef struct {
+    char signature[4];
+    uint32_t length;         // en-tete compris
+    uint8_t revision;
+    uint8_t checksum;        // la somme de tous les octets de la table vaut 0
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed)) AcpiHeader;
+
+/* MADT : en-tete puis entrees de longueur variable (type, longueur, donnees) */
+typedef struct {
+    AcpiHeader header;
+    uint32_t lapic_address;
+    uint32_t flags;
+} __attribute__((packed)) AcpiMadtHeader;
+
+#define MADT_LOCAL_APIC          0 // processeur : ID ACPI, ID local APIC, flags
+#define MADT_LAPIC_ADDRESS       5 // adresse 64-bit qui remplace lapic_address
+#define MADT_LAPIC_ENABLED       (1u << 0) // seul bit retenu : "online capable" (bit 1) demande un hot-plug
+
+/* --- Zones ou chercher le RSDP --- */
+static const uint32_t BDA_EBDA_SEGMENT = 0x40E; // mot de la BIOS Data Area : segment de l'EBDA
+static const uint32_t EBDA_SEARCH_SIZE = 1024;  // le RSDP est dans le premier KB de l'EBDA...
+static const uint32_t BIOS_AREA_START = 0xE0000; // ... ou dans la zone ROM du BIOS
+static const uint32_t BIOS_AREA_END = 0x100000;
+
+static int signature_equal(const char* a, const char* b, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (a[i] != b[i]) return 0;
+    }
+    return 1;
+}
+
+static uint8_t checksum(const void* data, size_t len) {
+    const uint8_t* bytes = data;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < len; i++) sum += bytes[i];
+    return sum;
+}
+
+/* Le RSDP est aligne sur 16 octets, la signature seule ne suffit pas : la somme de controle doit etre nulle */
+static const AcpiRsdp* rsdp_scan(uint32_t start, uint32_t end) {
+    for (uint32_t address = start & ~15u; address + sizeof(AcpiRsdp) <= end; address += 16) {
+        const AcpiRsdp* rsdp = (const AcpiRsdp*) address;
+        if (signature_equal(rsdp->signature, "RSD PTR ", 8) && checksum(rsdp, 20) == 0) return rsdp;
+    }
+    return NULL;
+}
+
+static const AcpiRsdp* rsdp_find(void) {
+    uint32_t ebda = (uint32_t) *(const volatile uint16_t*) BDA_EBDA_SEGMENT << 4;
+    const AcpiRsdp* rsdp = NULL;
+    if (ebda) rsdp = rsdp_scan(ebda, ebda + EBDA_SEARCH_SIZE);
+    if (!rsdp) rsdp = rsdp_scan(BIOS_AREA_START, BIOS_AREA_END);
+    return rsdp;
+}
+
+static int table_valid(const AcpiHeader* table, const char* signature) {
+    return signature_equal(table->signature, signature, 4) && table->length >= sizeof(AcpiHeader)
+           && checksum(table, table->length) == 0;
+}
+
+/* Parcourt la RSDT (pointeurs 32-bit) ou la XSDT (pointeurs 64-bit, ignores au-dessus de 4 GiB) */
+static const AcpiHeader* table_find(const AcpiRsdp* rsdp, const char* signature) {
+    const AcpiHeader* root;
+    size_t entry_size;
+
+    if (rsdp->revision >= 2 && rsdp->xsdt_address && !(rsdp->xsdt_address >> 32)) {
+        root = (const AcpiHeader*) (uint32_t) rsdp->xsdt_address;
+        entry_size = 8;
+        if (!table_valid(root, "XSDT")) return NULL;
+    } else {
+        root = (const AcpiHeader*) rsdp->rsdt_address;
+        entry_size = 4;
+        if (!table_valid(root, "RSDT")) return NULL;
+    }
+
+    const uint8_t* entries = (const uint8_t*) (root + 1);
+    size_t count = (root->length - sizeof(AcpiHeader)) / entry_size;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t address = (entry_size == 8) ? *(const uint64_t*) (entries + i * 8) : *(const uint32_t*) (entries + i * 4);
+        if (address == 0 || (address >> 32)) continue;
+        const AcpiHeader* table = (const AcpiHeader*) (uint32_t) address;
+        if (table_valid(table, signature)) return table;
+    }
+    return NULL;
+}
+
+int acpi_read_madt(AcpiMadt* madt, uint8_t bsp_id) {
+    const AcpiRsdp* rsdp = rsdp_find();
+    if (!rsdp) return 0;
+    const AcpiMadtHeader* header = (const AcpiMadtHeader*) table_find(rsdp, "APIC");
+    if (!header || header->header.length < sizeof(AcpiMadtHeader)) return 0;
+
+    madt->lapic_address = header->lapic_address;
+    madt->apic_ids[0] = bsp_id;
+    madt->cpu_count = 1;
+    madt->ignored = 0;
+
+    const uint8_t* entry = (const uint8_t*) (header + 1);
+    const uint8_t* end = (const uint8_t*) header + header->header.length;
+    while (entry + 2 <= end && entry[1] >= 2 && entry + entry[1] <= end) {
+        if (entry[0] == MADT_LOCAL_APIC && entry[1] >= 8) {
+            uint32_t flags = *(const uint32_t*) (entry + 4);
+            if ((flags & MADT_LAPIC_ENABLED) && entry[3] != bsp_id) {
+                if (madt->cpu_count < ACPI_MAX_CPUS) madt->apic_ids[madt->cpu_count++] = entry[3];
+                else madt->ignored++;
+            }
+        } else if (entry[0] == MADT_LAPIC_ADDRESS && entry[1] >= 12) {
+            uint64_t address = *(const uint64_t*) (entry + 4);
+            if (!(address >> 32)) madt->lapic_address = (uint32_t) address;
+        }
+        entry += entry[1];
+    }
+    return 1;
+}
@@ -0,0 +1,24 @@
+#ifndef ACPI_H
+#define ACPI_H
+
+#include <stdint.h>
+
+/* Lecture des tables ACPI laissees en memoire par le BIOS : RSDP (EBDA ou zone 0xE0000-0xFFFFF), puis RSDT (ou XSDT)
+   et la MADT ("APIC") qui liste les processeurs. Pas de pagination : les adresses physiques sont lues telles quelles */
+
+#define ACPI_MAX_CPUS 8 // processeurs gardes (le BSP toujours), les suivants sont comptes dans ignored
+
+/* Ce que la MADT dit des processeurs */
+typedef struct {
+    uint32_t lapic_address;           // adresse physique des registres du local APIC (la meme pour tous les CPUs)
+    uint32_t cpu_count;               // processeurs actives gardes, BSP compris (au plus ACPI_MAX_CPUS)
+    uint8_t apic_ids[ACPI_MAX_CPUS];  // ID local APIC de chacun : le BSP en 0, puis les APs dans l'ordre de la table
+    uint32_t ignored;                 // processeurs actives au-dela de ACPI_MAX_CPUS
+} AcpiMadt;
+
+/* Cherche la MADT et remplit *madt. Seuls les processeurs actives (pas ceux "online capable") sont gardes.
+   Le slot 0 est reserve a bsp_id, ou qu'il soit dans la table : le BSP n'est jamais compte dans ignored.
+   Retourne 0 sans RSDP, sans MADT ou si une somme de controle est fausse */
+int acpi_read_madt(AcpiMadt* madt, uint8_t bsp_id);
+
+#endif
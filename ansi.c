@@ -0,0 +1,118 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "ansi.h"
+
+/* Classes d'octets : la transition ne depend que de l'etat et de la classe */
+enum {
+    CLASS_PRINT,        // 0x20-0x7E hors classes suivantes, et 0x80-0xFF (glyphes code page 437)
+    CLASS_CONTROL,      // C0 (\n, \b, \t...) : execute tel quel, meme au milieu d'une sequence
+    CLASS_ESC,          // 0x1B
+    CLASS_CANCEL,       // CAN 0x18, SUB 0x1A : abandonne la sequence en cours
+    CLASS_DIGIT,        // '0'-'9'
+    CLASS_SEPARATOR,    // ';'
+    CLASS_PRIVATE,      // '<' '=' '>' '?'
+    CLASS_INTERMEDIATE, // 0x20-0x2F
+    CLASS_BRACKET,      // '[' (CSI apres ESC)
+    CLASS_FINAL,        // 0x40-0x7E (sauf '[')
+    CLASS_COUNT
+};
+
+static uint8_t byte_class(uint8_t byte) {
+    if (byte == 0x1B) return CLASS_ESC;
+    if (byte == 0x18 || byte == 0x1A) return CLASS_CANCEL;
+    if (byte < 0x20) return CLASS_CONTROL;
+    if (byte >= 0x80 || byte == 0x7F) return CLASS_PRINT;
+    if (byte >= '0' && byte <= '9') return CLASS_DIGIT;
+    if (byte == ';') return CLASS_SEPARATOR;
+    if (byte >= '<' && byte <= '?') return CLASS_PRIVATE;
+    if (byte < 0x30) return CLASS_INTERMEDIATE;
+    if (byte == '[') return CLASS_BRACKET;
+    if (byte >= 0x40) return CLASS_FINAL;
+    return CLASS_PRINT; // ':' hors sequence
+}
+
+/* Operations appliquees a l'octet avant de changer d'etat */
+enum {
+    OP_PRINT,      // ANSI_PRINT
+    OP_NONE,       // avale
+    OP_START,      // debut de sequence : parametres remis a zero
+    OP_DIGIT,      // chiffre du parametre courant
+    OP_SEPARATOR,  // parametre suivant
+    OP_PRIVATE,    // marque privee (seulement avant le premier parametre)
+    OP_ESC_FINAL,  // ANSI_ESC_DISPATCH
+    OP_CSI_FINAL,  // ANSI_CSI_DISPATCH
+};
+
+typedef struct {
+    uint8_t op;
+    uint8_t next;
+} Transition;
+
+#define T(op, next) { OP_##op, ANSI_##next }
+
+static const Transition transitions[4][CLASS_COUNT] = {
+    [ANSI_GROUND] = {
+        [CLASS_PRINT] = T(PRINT, GROUND), [CLASS_CONTROL] = T(PRINT, GROUND), [CLASS_ESC] = T(START, ESCAPE),
+        [CLASS_CANCEL] = T(PRINT, GROUND), [CLASS_DIGIT] = T(PRINT, GROUND), [CLASS_SEPARATOR] = T(PRINT, GROUND),
+        [CLASS_PRIVATE] = T(PRINT, GROUND), [CLASS_INTERMEDIATE] = T(PRINT, GROUND), [CLASS_BRACKET] = T(PRINT, GROUND),
+        [CLASS_FINAL] = T(PRINT, GROUND),
+    },
+    [ANSI_ESCAPE] = {
+        [CLASS_PRINT] = T(NONE, GROUND), [CLASS_CONTROL] = T(PRINT, ESCAPE), [CLASS_ESC] = T(START, ESCAPE),
+        [CLASS_CANCEL] = T(NONE, GROUND), [CLASS_DIGIT] = T(ESC_FINAL, GROUND), [CLASS_SEPARATOR] = T(ESC_FINAL, GROUND),
+        [CLASS_PRIVATE] = T(ESC_FINAL, GROUND), [CLASS_INTERMEDIATE] = T(NONE, IGNORE), [CLASS_BRACKET] = T(START, CSI),
+        [CLASS_FINAL] = T(ESC_FINAL, GROUND),
+    },
+    [ANSI_CSI] = {
+        [CLASS_PRINT] = T(NONE, IGNORE), [CLASS_CONTROL] = T(PRINT, CSI), [CLASS_ESC] = T(START, ESCAPE),
+        [CLASS_CANCEL] = T(NONE, GROUND), [CLASS_DIGIT] = T(DIGIT, CSI), [CLASS_SEPARATOR] = T(SEPARATOR, CSI),
+        [CLASS_PRIVATE] = T(PRIVATE, CSI), [CLASS_INTERMEDIATE] = T(NONE, IGNORE), [CLASS_BRACKET] = T(CSI_FINAL, GROUND),
+        [CLASS_FINAL] = T(CSI_FINAL, GROUND),
+    },
+    [ANSI_IGNORE] = {
+        [CLASS_PRINT] = T(NONE, IGNORE), [CLASS_CONTROL] = T(PRINT, IGNORE), [CLASS_ESC] = T(START, ESCAPE),
+        [CLASS_CANCEL] = T(NONE, GROUND), [CLASS_DIGIT] = T(NONE, IGNORE), [CLASS_SEPARATOR] = T(NONE, IGNORE),
+        [CLASS_PRIVATE] = T(NONE, IGNORE), [CLASS_INTERMEDIATE] = T(NONE, IGNORE), [CLASS_BRACKET] = T(NONE, GROUND),
+        [CLASS_FINAL] = T(NONE, GROUND),
+    },
+};
+
+AnsiAction ansi_feed(AnsiParser* parser, uint8_t byte) {
+    const Transition* transition = &transitions[parser->state][byte_class(byte)];
+    parser->state = transition->next;
+
+    switch (transition->op) {
+        case OP_PRINT:
+            return ANSI_PRINT;
+        case OP_START:
+            parser->count = 0;
+            parser->private_mark = 0;
+            return ANSI_NONE;
+        case OP_DIGIT:
+            if (parser->count == 0) parser->params[parser->count++] = 0;
+            if (parser->count <= ANSI_MAX_PARAMS) {
+                uint16_t* param = &parser->params[parser->count - 1];
+                uint32_t value = *param * 10u + (uint32_t) (byte - '0');
+                *param = (uint16_t) (value > ANSI_PARAM_MAX ? ANSI_PARAM_MAX : value);
+            }
+            return ANSI_NONE;
+        case OP_SEPARATOR:
+            /* "ESC[;5H" : le premier parametre est vide. Au-dela de ANSI_MAX_PARAMS les parametres sont ignores */
+            if (parser->count == 0) parser->params[parser->count++] = 0;
+            if (parser->count < ANSI_MAX_PARAMS) parser->params[parser->count] = 0;
+            if (parser->count <= ANSI_MAX_PARAMS) parser->count++;
+            return ANSI_NONE;
+        case OP_PRIVATE:
+            if (parser->count == 0 && !parser->private_mark) parser->private_mark = byte;
+            else parser->state = ANSI_IGNORE;
+            return ANSI_NONE;
+        case OP_ESC_FINAL:
+            parser->final = byte;
+            return ANSI_ESC_DISPATCH;
+        case OP_CSI_FINAL:
+            parser->final = byte;
+            if (parser->count > ANSI_MAX_PARAMS) parser->count = ANSI_MAX_PARAMS;
+            return ANSI_CSI_DISPATCH;
+    }
+    return ANSI_NONE;
+}
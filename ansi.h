@@ -0,0 +1,50 @@
+#ifndef ANSI_H
+#define ANSI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Decodeur des sequences d'echappement ANSI / VT100 place devant terminal_putchar.
+   Il ne fait que reconnaitre les sequences (ESC x, ESC [ params final) : leur effet (couleurs, curseur, effacement)
+   est applique par le terminal, par des tables indexees sur l'octet final (voir terminal.c) */
+
+#define ANSI_MAX_PARAMS 8
+#define ANSI_PARAM_MAX 9999 // un parametre plus grand est sature
+
+typedef enum {
+    ANSI_GROUND,  // texte normal
+    ANSI_ESCAPE,  // ESC recu
+    ANSI_CSI,     // ESC [ recu : parametres jusqu'a l'octet final
+    ANSI_IGNORE,  // sequence invalide ou non supportee : ignoree jusqu'a son octet final
+} AnsiState;
+
+/* Ce que l'appelant doit faire de l'octet */
+typedef enum {
+    ANSI_NONE,          // l'octet fait partie d'une sequence en cours
+    ANSI_PRINT,         // caractere ou octet de controle (\n, \b...) a traiter normalement
+    ANSI_ESC_DISPATCH,  // ESC final termine : final
+    ANSI_CSI_DISPATCH,  // ESC [ params final termine : final, params[0..count), private_mark
+} AnsiAction;
+
+typedef struct {
+    uint8_t state;         // AnsiState
+    uint8_t final;         // octet final de la derniere sequence
+    uint8_t private_mark;  // '?' (ou '<', '=', '>') en tete des parametres, 0 sinon
+    uint8_t count;         // parametres recus (un parametre vide compte, il vaut 0)
+    uint16_t params[ANSI_MAX_PARAMS];
+} AnsiParser;
+
+static inline void ansi_init(AnsiParser* parser) {
+    parser->state = ANSI_GROUND;
+    parser->count = 0;
+}
+
+/* Fait avancer la machine a etats d'un octet */
+AnsiAction ansi_feed(AnsiParser* parser, uint8_t byte);
+
+/* Parametre index, ou fallback s'il est absent ou nul (convention VT100 : ESC[H = ESC[1;1H) */
+static inline uint16_t ansi_param(const AnsiParser* parser, size_t index, uint16_t fallback) {
+    return (index < parser->count && parser->params[index]) ? parser->params[index] : fallback;
+}
+
+#endif
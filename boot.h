@@ -0,0 +1,26 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include "cpu.h"
+
+/* Horodatage des etapes du boot au TSC. BOOT_START est ecrit par _start (boot.S), les autres par kernel_main().
+   Ils ne sont convertis en temps qu'a l'affichage (commande boot), une fois le TSC calibre */
+typedef enum {
+    BOOT_START,     // entree de _start
+    BOOT_MAIN,      // entree de kernel_main
+    BOOT_TERMINAL,  // ecran F1 pret (alloue et rendu)
+    BOOT_PROMPT,    // banniere affichee, saisie ouverte
+    BOOT_KEYBOARD,  // IDT, clavier et timer branches, interruptions actives
+    BOOT_STAGE_COUNT
+} BootStage;
+
+/* 0 : etape pas encore atteinte, ou pas de TSC (dans ce cas _start laisse boot_stamps[BOOT_START] a 0) */
+extern uint64_t boot_stamps[BOOT_STAGE_COUNT];
+extern const char* const boot_stage_names[BOOT_STAGE_COUNT];
+
+static inline void boot_mark(BootStage stage) {
+    if (boot_stamps[BOOT_START]) boot_stamps[stage] = rdtsc();
+}
+
+#endif
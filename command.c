@@ -0,0 +1,335 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "boot.h"
+#include "command.h"
+#include "fb.h"
+#include "keyboard.h"
+#include "log.h"
+#include "math64.h"
+#include "pmm.h"
+#include "printk.h"
+#include "ps2.h"
+#include "serial.h"
+#include "smp.h"
+#include "string.h"
+#include "terminal.h"
+#include "timer.h"
+#include "trace.h"
+
+/* --- Commandes --- */
+/* Chaque commande recoit le reste de la ligne apres son nom (sans les espaces de tete) */
+typedef struct {
+    const char* name;
+    const char* help;
+    void (*run)(const char* args);
+} Command;
+
+static void cmd_help(const char* args);
+
+static void cmd_bench(const char* args) {
+    (void) args;
+    string_benchmark();
+}
+
+static void cmd_stats(const char* args) {
+    (void) args;
+    printk("render: %d flushes, %d cells to VRAM (last %d, max %d), %d cursor writes\n",
+           render_stats.flushes, render_stats.cells_written, render_stats.last_cells,
+           render_stats.max_cells, render_stats.cursor_writes);
+    if (fb_stats.frames) {
+        printk("fb: %u frames, %u glyphs drawn (last %u)\n", fb_stats.frames, fb_stats.glyphs, fb_stats.last);
+    }
+
+    /* Ecrans ouverts et memoire de leur historique */
+    uint32_t open_screens = 0, history_kb = 0;
+    for (int i = 0; i < TERMINAL_MAX_SCREENS; i++) {
+        Terminal* term = terminal_get(i);
+        if (!term) continue;
+        open_screens++;
+        history_kb += TERMINAL_STORAGE_SIZE(term->lines, term->history.width) / 1024;
+    }
+    printk("screens: %u/%u open, %u KB of history (F%d: %u lines)\n", open_screens, TERMINAL_MAX_SCREENS,
+           history_kb, terminal_active()->index + 1, (uint32_t) terminal_active()->lines);
+    printk("keyboard: %d scancodes, %d dropped, ring high-water %d, %u commands failed\n",
+           ps2_stats.received, ps2_stats.dropped, ps2_stats.high_water, ps2_stats.command_errors);
+    printk("keys: %u events (%u repeats, %u bytes ignored) in %u batches (max %u), layout %s\n",
+           keyboard_stats.events, keyboard_stats.repeats, keyboard_stats.ignored, keyboard_stats.batches,
+           keyboard_stats.max_batch, keyboard_layout()->name);
+
+    /* Latence appui -> VRAM, du TSC de l'IRQ1 a la fin du rendu */
+    uint32_t count = keyboard_stats.latency_count;
+    uint64_t average = count ? udiv64_32(keyboard_stats.latency_total, count, NULL) : 0;
+    printk("latency: %u presses, avg %u ns, max %u ns, last %u ns\n", count, (uint32_t) tsc_to_ns(average),
+           (uint32_t) tsc_to_ns(keyboard_stats.latency_max), (uint32_t) tsc_to_ns(keyboard_stats.latency_last));
+    printk("serial: %d bytes sent, %d dropped, ring high-water %d, %d THRE irqs\n",
+           serial_stats.bytes_sent, serial_stats.dropped, serial_stats.high_water, serial_stats.tx_irqs);
+    printk("log: %d records, %d overwritten, %d truncated\n",
+           log_stats.records, log_stats.overwritten, log_stats.truncated);
+    printk("timer: %d ticks at %d Hz, TSC %d kHz\n", timer_ticks, TIMER_HZ, tsc_khz);
+}
+
+static void cmd_render(const char* args) {
+    if (strcmp(args, "pan") == 0) terminal_set_panning(1);
+    else if (strcmp(args, "copy") == 0) terminal_set_panning(0);
+    else printk("usage: render pan|copy\n");
+}
+
+static void cmd_console(const char* args) {
+    if (strcmp(args, "vga") == 0) console_sinks = CONSOLE_VGA;
+    else if (strcmp(args, "serial") == 0) console_sinks = CONSOLE_SERIAL;
+    else if (strcmp(args, "both") == 0) console_sinks = CONSOLE_VGA | CONSOLE_SERIAL;
+    else printk("usage: console vga|serial|both\n");
+}
+
+static void cmd_baud(const char* args) {
+    uint32_t rate = 0;
+
+    while (*args >= '0' && *args <= '9') rate = rate * 10 + (*args++ - '0');
+    /* Le diviseur doit tomber juste : 115200, 57600, 38400, 19200, 9600... */
+    if (rate == 0 || rate > 115200 || 115200 % rate != 0) {
+        printk("usage: baud <rate>, rate must divide 115200\n");
+        return;
+    }
+    serial_set_divisor(115200 / rate);
+}
+
+static void cmd_layout(const char* args) {
+    if (args[0] != '\0' && keyboard_set_layout(args)) return;
+
+    printk("usage: layout");
+    for (int i = 0; keyboard_layout_names[i]; i++) printk("%s%s", i ? "|" : " ", keyboard_layout_names[i]);
+    printk(" (current: %s)\n", keyboard_layout()->name);
+}
+
+static uint32_t cycles_to_us(uint64_t cycles) {
+    return (uint32_t) udiv64_32(tsc_to_ns(cycles), 1000, NULL);
+}
+
+/* Etapes du boot : temps depuis _start et depuis l'etape precedente. Le temps jusqu'au prompt sert de metrique */
+static void cmd_boot(const char* args) {
+    (void) args;
+    if (boot_stamps[BOOT_START] == 0 || tsc_khz == 0) {
+        printk("boot: no TSC, stages not recorded\n");
+        return;
+    }
+
+    printk("%-12s %10s %10s\n", "stage", "since", "step (us)");
+    uint64_t previous = boot_stamps[BOOT_START];
+    for (int stage = 0; stage < BOOT_STAGE_COUNT; stage++) {
+        uint64_t stamp = boot_stamps[stage];
+        if (stamp == 0) continue;
+        printk("%-12s %10u %10u\n", boot_stage_names[stage], cycles_to_us(stamp - boot_stamps[BOOT_START]),
+               cycles_to_us(stamp - previous));
+        previous = stamp;
+    }
+    printk("time to prompt: %u us\n", cycles_to_us(boot_stamps[BOOT_PROMPT] - boot_stamps[BOOT_START]));
+}
+
+/* Relit tout le ring de log avec l'horodatage et le niveau de chaque record */
+static void cmd_dmesg(const char* args) {
+    (void) args;
+    LogCursor cursor;
+    LogRecord record;
+    char text[LOG_TEXT_MAX + 1];
+    /* dmesg ecrit lui-meme dans le log : on s'arrete aux records presents au lancement */
+    uint32_t end = log_stats.records;
+
+    log_cursor_init(&cursor);
+    while (log_read(&cursor, &record, text, sizeof(text)) && (int32_t) (record.seq - end) < 0) {
+        uint32_t ns;
+        uint32_t sec = (uint32_t) udiv64_32(record.timestamp_ns, 1000000000u, &ns);
+        int newline = (record.len > 0 && text[record.len - 1] == '\n');
+
+        printk("[%5u.%06u] <%d> %s%s", sec, ns / 1000, record.level, text, newline ? "" : "\n");
+    }
+    if (cursor.lost) printk("dmesg: %u records overwritten while reading\n", cursor.lost);
+}
+
+/* Memory map vue au boot et etat de l'allocateur de pages */
+static void cmd_mem(const char* args) {
+    (void) args;
+    static const char* type_names[] = { "?", "available", "reserved", "ACPI", "NVS", "bad" };
+    PmmStats stats;
+
+    for (size_t i = 0; i < pmm_region_count; i++) {
+        uint32_t type = pmm_regions[i].type;
+        printk("  %016llx-%016llx %s\n", pmm_regions[i].base, pmm_regions[i].base + pmm_regions[i].length - 1,
+               type_names[type <= MULTIBOOT_MEMORY_BADRAM ? type : 0]);
+    }
+
+    pmm_get_stats(&stats);
+    /* Fragmentation : part de la memoire libre qui n'est pas dans le plus grand trou (au plus 2^20 pages : pas de debordement) */
+    uint32_t fragmentation = stats.free_pages ? 100 - stats.largest_run * 100 / stats.free_pages : 0;
+    printk("pages: %u total, %u free, %u used (%u KB free)\n",
+           stats.total_pages, stats.free_pages, stats.used_pages, stats.free_pages * (PAGE_SIZE / 1024));
+    printk("free runs: %u, largest %u pages, fragmentation %u%%\n", stats.free_runs, stats.largest_run, fragmentation);
+}
+
+/* Debit d'un lancement de smp_bench() en MB/s (octets par microseconde) */
+static uint32_t bench_mb_per_s(const SmpBenchResult* result) {
+    uint32_t us = cycles_to_us(result->cycles);
+    return us ? (uint32_t) udiv64_32(result->bytes, us, NULL) : 0;
+}
+
+/* CPUs en ligne et leur file de sortie. 'smp bench' lance le checksum sur 1, 2 .. N CPUs : le debit total doit
+   croitre avec le nombre de CPUs (chacun lit son propre buffer, rien n'est partage pendant le calcul) */
+static void cmd_smp(const char* args) {
+    if (args[0] == '\0') {
+        printk("%u/%u CPUs online\n", smp_cpu_count, smp_madt_cpus ? smp_madt_cpus : 1);
+        for (uint32_t cpu = 0; cpu < smp_cpu_count; cpu++) {
+            printk("  cpu%u: APIC ID %u, %s, %u messages dropped\n", cpu, smp_cpus[cpu].apic_id,
+                   cpu ? "worker" : "console owner", smp_cpus[cpu].queue.dropped);
+        }
+        return;
+    }
+    if (strcmp(args, "bench") != 0) {
+        printk("usage: smp [bench]\n");
+        return;
+    }
+    if (tsc_khz == 0) {
+        printk("smp: no TSC, cannot time the workload\n");
+        return;
+    }
+
+    uint32_t single = 0;
+    printk("%-5s %10s %8s  %s\n", "cpus", "MB/s", "scaling", "checksums");
+    for (uint32_t cpus = 1; cpus <= smp_cpu_count; cpus++) {
+        SmpBenchResult result;
+        if (!smp_bench(cpus, &result)) {
+            printk("smp: run on %u CPUs failed (no memory or a CPU did not finish)\n", cpus);
+            return;
+        }
+        uint32_t rate = bench_mb_per_s(&result);
+        if (cpus == 1) single = rate;
+        uint32_t scaling = single ? (uint32_t) udiv64_32((uint64_t) rate * 100, single, NULL) : 0;
+        printk("%-5u %10u %5u.%02ux  %s\n", cpus, rate, scaling / 100, scaling % 100,
+               result.checksums_match ? "match" : "MISMATCH");
+    }
+}
+
+#if TRACE_ENABLED
+/* Une ligne par point de trace : nombre d'appels, moyenne, percentiles (a la precision du bucket log2) et max */
+static void trace_summary(void) {
+    TraceHistogram histogram;
+
+    printk("%-9s %8s %8s %8s %8s %10s  (cycles, p99 in ns)\n", "site", "count", "avg", "p50", "p99", "max");
+    for (int site = 0; site < TRACE_SITE_COUNT; site++) {
+        trace_snapshot(site, &histogram);
+        if (histogram.count == 0) continue;
+        uint32_t avg = (uint32_t) udiv64_32(histogram.total, histogram.count, NULL);
+        uint32_t p99 = trace_percentile(&histogram, 99);
+        printk("%-9s %8u %8u %8u %8u %10u  %u ns\n", trace_site_names[site], histogram.count, avg,
+               trace_percentile(&histogram, 50), p99, histogram.max, (uint32_t) tsc_to_ns(p99));
+    }
+}
+
+/* Histogramme log2 d'un site : une barre par bucket non vide */
+static void trace_histogram(int site) {
+    TraceHistogram histogram;
+    uint32_t peak = 0;
+
+    trace_snapshot(site, &histogram);
+    for (int b = 0; b < TRACE_BUCKETS; b++) {
+        if (histogram.buckets[b] > peak) peak = histogram.buckets[b];
+    }
+    printk("%s: %u calls, p50 %u, p99 %u cycles\n", trace_site_names[site], histogram.count,
+           trace_percentile(&histogram, 50), trace_percentile(&histogram, 99));
+    for (int b = 0; b < TRACE_BUCKETS; b++) {
+        if (histogram.buckets[b] == 0) continue;
+        char bar[41];
+        uint32_t len = (uint32_t) udiv64_32((uint64_t) histogram.buckets[b] * 40 + peak - 1, peak, NULL);
+        memset(bar, '#', len);
+        bar[len] = '\0';
+        printk("  < 2^%-2d %8u %s\n", b + 1, histogram.buckets[b], bar);
+    }
+}
+
+/* Derniers evenements du ring, dates depuis le plus ancien affiche */
+static void trace_last_events(void) {
+    TraceEvent events[16];
+    size_t count = trace_events(events, 16);
+    for (size_t i = 0; i < count; i++) {
+        printk("  +%10u %-9s %8u cycles\n", (uint32_t) (events[i].start - events[0].start),
+               trace_site_names[events[i].site], events[i].cycles);
+    }
+}
+#endif
+
+static void cmd_trace(const char* args) {
+#if TRACE_ENABLED
+    if (args[0] == '\0') {
+        trace_summary();
+        return;
+    }
+    if (strcmp(args, "reset") == 0) {
+        trace_reset();
+        return;
+    }
+    if (strcmp(args, "events") == 0) {
+        trace_last_events();
+        return;
+    }
+    for (int site = 0; site < TRACE_SITE_COUNT; site++) {
+        if (strcmp(args, trace_site_names[site]) == 0) {
+            trace_histogram(site);
+            return;
+        }
+    }
+    printk("usage: trace [reset|events");
+    for (int site = 0; site < TRACE_SITE_COUNT; site++) printk("|%s", trace_site_names[site]);
+    printk("]\n");
+#else
+    (void) args;
+    printk("trace: compiled out (build with make TRACE=1)\n");
+#endif
+}
+
+static const Command commands[] = {
+    { "help",  "list commands",                          cmd_help },
+    { "bench", "memory primitives benchmark (cycles/KB)", cmd_bench },
+    { "stats", "render, keyboard and timer counters",    cmd_stats },
+    { "render", "pan: CRTC panning, copy: copy the view", cmd_render },
+    { "console", "printk sinks: vga, serial or both",    cmd_console },
+    { "baud",  "serial line speed (COM1)",               cmd_baud },
+    { "layout", "keyboard layout: us or fr (AZERTY)",    cmd_layout },
+    { "dmesg", "kernel log with timestamps and levels",  cmd_dmesg },
+    { "mem",   "memory map and page allocator stats",    cmd_mem },
+    { "boot",  "boot stage timestamps, time to prompt",  cmd_boot },
+    { "trace", "hot path cycle histograms (p50/p99)",     cmd_trace },
+    { "smp",   "CPUs online, 'smp bench': parallel scaling", cmd_smp },
+};
+
+static const size_t COMMAND_COUNT = sizeof(commands) / sizeof(commands[0]);
+
+static void cmd_help(const char* args) {
+    (void) args;
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        printk("  %s - %s\n", commands[i].name, commands[i].help);
+    }
+}
+
+void command_execute(const char* line) {
+    char name[32];
+    size_t len = 0;
+
+    while (*line == ' ') line++;
+    if (*line == '\0') return;
+
+    /* Isole le premier mot */
+    while (line[len] && line[len] != ' ' && len < sizeof(name) - 1) {
+        name[len] = line[len];
+        len++;
+    }
+    name[len] = '\0';
+
+    const char* args = line + len;
+    while (*args == ' ') args++;
+
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (strcmp(commands[i].name, name) == 0) {
+            commands[i].run(args);
+            return;
+        }
+    }
+    printk("%s: command not found (try 'help')\n", name);
+}
@@ -0,0 +1,7 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+/* Execute une ligne saisie par l'utilisateur ("nom arguments"). Une ligne vide ne fait rien */
+void command_execute(const char* line);
+
+#endif
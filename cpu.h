@@ -0,0 +1,66 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+/* --- CPUID --- */
+/* Bits de CPUID leaf 1 (EDX) */
+#define CPUID_EDX_TSC  (1u << 4)
+#define CPUID_EDX_APIC (1u << 9)
+#define CPUID_EDX_SSE2 (1u << 26)
+
+static inline void cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx)
+{
+    __asm__ volatile ( "cpuid"
+                   : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                   : "a"(leaf), "c"(0) );
+}
+
+/* Retourne EDX de CPUID leaf 1 (flags des fonctionnalites) */
+static inline uint32_t cpuid_features_edx(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    return edx;
+}
+
+/* Retourne l'ID local APIC initial du CPU qui execute (CPUID leaf 1, EBX bits 24-31), lisible sans le local APIC */
+static inline uint8_t cpuid_initial_apic_id(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    return (uint8_t) (ebx >> 24);
+}
+
+/* --- SSE --- */
+/* Autorise les instructions SSE : CR0.EM = 0 (pas d'emulation FPU), CR0.MP = 1,
+   CR4.OSFXSR = 1 (fxsave/fxrstor + SSE) et CR4.OSXMMEXCPT = 1 (exceptions SIMD en #XM).
+   Registres de controle en uintptr_t : string.c s'assemble aussi pour l'hote 64-bit (tests/test_string.c) */
+static inline void cpu_enable_sse(void)
+{
+    uintptr_t cr0, cr4;
+    __asm__ volatile ( "mov %%cr0, %0" : "=r"(cr0) );
+    cr0 &= ~(1u << 2);
+    cr0 |= (1u << 1);
+    __asm__ volatile ( "mov %0, %%cr0" : : "r"(cr0) );
+    __asm__ volatile ( "mov %%cr4, %0" : "=r"(cr4) );
+    cr4 |= (1u << 9) | (1u << 10);
+    __asm__ volatile ( "mov %0, %%cr4" : : "r"(cr4) );
+}
+
+/* Attente active : pause laisse le coeur voisin (hyperthreading) avancer et evite la penalite de sortie de boucle */
+static inline void cpu_relax(void)
+{
+    __asm__ volatile ( "pause" ::: "memory" );
+}
+
+/* --- Time Stamp Counter --- */
+/* Compteur de cycles 64-bit (EDX:EAX) */
+static inline uint64_t rdtsc(void)
+{
+    uint32_t lo, hi;
+    __asm__ volatile ( "rdtsc" : "=a"(lo), "=d"(hi) );
+    return ((uint64_t) hi << 32) | lo;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "fb.h"
+#include "font.h"
+#include "multiboot.h"
+#include "trace.h"
+#include "vga.h"
+
+/* Blitter de la console framebuffer.
+   Une ligne de glyphe (un octet de la police) devient 8 pixels 32 bits sans test par pixel : glyph_masks[octet] donne
+   pour chaque pixel un masque plein ou vide, et pixel = bg ^ ((fg ^ bg) & masque). Chaque glyphe est ecrit ligne
+   de pixels par ligne de pixels (8 pixels contigus a la fois).
+   drawn garde les cellules affichees : fb_draw() ne redessine que celles qui different de la VRAM (et les deux
+   cellules du curseur quand il bouge). Le framebuffer n'est jamais relu (memoire video non cachee, lente en lecture) :
+   apres un scroll les lignes decalees sont redessinees depuis les cellules, sauf celles qui n'ont pas change a leur
+   position (fins de ligne vides) */
+
+#define CURSOR_HEIGHT 2        // soulignement, comme le curseur texte par defaut de la VGA
+#define NO_CURSOR ((size_t) -1)
+
+/* Palette VGA par defaut (composantes 8 bits), dans l'ordre de enum vga_color */
+static const uint8_t vga_palette[16][3] = {
+    { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0xAA }, { 0x00, 0xAA, 0x00 }, { 0x00, 0xAA, 0xAA },
+    { 0xAA, 0x00, 0x00 }, { 0xAA, 0x00, 0xAA }, { 0xAA, 0x55, 0x00 }, { 0xAA, 0xAA, 0xAA },
+    { 0x55, 0x55, 0x55 }, { 0x55, 0x55, 0xFF }, { 0x55, 0xFF, 0x55 }, { 0x55, 0xFF, 0xFF },
+    { 0xFF, 0x55, 0x55 }, { 0xFF, 0x55, 0xFF }, { 0xFF, 0xFF, 0x55 }, { 0xFF, 0xFF, 0xFF },
+};
+
+static FbMode fb;
+static size_t fb_rows;           // lignes de texte affichees
+static size_t fb_columns;        // cellules par ligne (la largeur des lignes du terminal)
+static size_t fb_left;           // marge gauche en pixels : les colonnes sont centrees
+static uint32_t palette[16];     // couleurs VGA au format du framebuffer
+static uint32_t glyph_masks[256][FONT_WIDTH];
+static uint16_t drawn[VGA_MAX_ROWS * VGA_MAX_COLUMNS];
+static size_t drawn_cursor = NO_CURSOR;
+static int drawn_valid = 0;      // 0 : rien n'est dessine, toute la vue est a faire
+
+FbStats fb_stats;
+
+int fb_mode_from_multiboot(const MultibootInfo* info, FbMode* mode) {
+    if (!(info->flags & MULTIBOOT_INFO_FRAMEBUFFER)) return 0;
+    if (info->framebuffer_type != MULTIBOOT_FRAMEBUFFER_TYPE_RGB || info->framebuffer_bpp != 32) return 0;
+    if (info->framebuffer_addr >> 32) return 0; // pas de pagination : il doit etre sous 4 GiB
+
+    mode->base = (uint8_t*) (uintptr_t) info->framebuffer_addr;
+    mode->pitch = info->framebuffer_pitch;
+    mode->width = info->framebuffer_width;
+    mode->height = info->framebuffer_height;
+    mode->red_position = info->framebuffer_red_position;
+    mode->red_size = info->framebuffer_red_mask_size;
+    mode->green_position = info->framebuffer_green_position;
+    mode->green_size = info->framebuffer_green_mask_size;
+    mode->blue_position = info->framebuffer_blue_position;
+    mode->blue_size = info->framebuffer_blue_mask_size;
+    return 1;
+}
+
+/* Composante 8 bits ramenee a size bits et placee a position */
+static uint32_t fb_component(uint8_t value, uint8_t position, uint8_t size) {
+    if (size > 8) size = 8;
+    return (uint32_t) (value >> (8 - size)) << position;
+}
+
+size_t fb_init(const FbMode* mode, size_t* columns) {
+    size_t rows = mode->height / FB_CELL_HEIGHT;
+    size_t width = mode->width / FB_CELL_WIDTH;
+    if (width < VGA_WIDTH || rows < VGA_HEIGHT) return 0;
+    if (rows > VGA_MAX_ROWS) rows = VGA_MAX_ROWS;
+    if (width > VGA_MAX_COLUMNS) width = VGA_MAX_COLUMNS;
+
+    fb = *mode;
+    fb_rows = rows;
+    fb_columns = width;
+    fb_left = (mode->width - width * FB_CELL_WIDTH) / 2;
+
+    for (int i = 0; i < 16; i++) {
+        palette[i] = fb_component(vga_palette[i][0], mode->red_position, mode->red_size)
+                   | fb_component(vga_palette[i][1], mode->green_position, mode->green_size)
+                   | fb_component(vga_palette[i][2], mode->blue_position, mode->blue_size);
+    }
+    for (int bits = 0; bits < 256; bits++) {
+        for (int x = 0; x < FONT_WIDTH; x++) glyph_masks[bits][x] = (bits & (0x80 >> x)) ? 0xFFFFFFFFu : 0;
+    }
+
+    /* Marges et lignes sous la vue en noir, la vue sera dessinee en entier au premier fb_draw() */
+    for (uint32_t y = 0; y < mode->height; y++) {
+        uint32_t* line = (uint32_t*) (mode->base + y * mode->pitch);
+        for (uint32_t x = 0; x < mode->width; x++) line[x] = palette[VGA_COLOR_BLACK];
+    }
+    drawn_valid = 0;
+    drawn_cursor = NO_CURSOR;
+    *columns = width;
+    return rows;
+}
+
+/* Dessine une cellule : 16 lignes de 8 pixels, la ligne i du glyphe sur les lignes de pixels 2i et 2i + 1 */
+static void fb_blit(size_t column, size_t row, uint16_t cell, int cursor) {
+    const uint8_t* glyph = font_8x8[cell & 0xFF];
+    uint32_t bg = palette[cell >> 12]; // pas de clignotement : le bit 7 de l'attribut donne les 16 couleurs de fond
+    uint32_t diff = palette[(cell >> 8) & 0x0F] ^ bg;
+    uint8_t* line = fb.base + (row * FB_CELL_HEIGHT) * fb.pitch + (fb_left + column * FB_CELL_WIDTH) * 4;
+
+    for (size_t y = 0; y < FB_CELL_HEIGHT; y++, line += fb.pitch) {
+        uint8_t bits = (cursor && y >= FB_CELL_HEIGHT - CURSOR_HEIGHT) ? 0xFF : glyph[y / 2];
+        const uint32_t* mask = glyph_masks[bits];
+        uint32_t* pixels = (uint32_t*) line;
+        pixels[0] = bg ^ (diff & mask[0]);
+        pixels[1] = bg ^ (diff & mask[1]);
+        pixels[2] = bg ^ (diff & mask[2]);
+        pixels[3] = bg ^ (diff & mask[3]);
+        pixels[4] = bg ^ (diff & mask[4]);
+        pixels[5] = bg ^ (diff & mask[5]);
+        pixels[6] = bg ^ (diff & mask[6]);
+        pixels[7] = bg ^ (diff & mask[7]);
+    }
+}
+
+static int row_equal(const uint16_t* a, const uint16_t* b) {
+    for (size_t x = 0; x < fb_columns; x++) {
+        if (a[x] != b[x]) return 0;
+    }
+    return 1;
+}
+
+void fb_draw(const uint16_t* vram, uint16_t start, uint16_t cursor) {
+    TRACE_SCOPE(TRACE_FB);
+    size_t cells = fb_rows * fb_columns;
+    size_t cursor_cell = (cursor >= start && (size_t) (cursor - start) < cells) ? (size_t) (cursor - start) : NO_CURSOR;
+    uint32_t count = 0;
+
+    /* La vue est lue a partir de start sans repli : le terminal garde start + la vue dans les VGA_SHADOW_CELLS cellules */
+    const uint16_t* view = vram + start;
+
+    size_t old_cursor = drawn_cursor;
+    int moved = (cursor_cell != old_cursor);
+    for (size_t y = 0; y < fb_rows; y++) {
+        const uint16_t* cells_row = &view[y * fb_columns];
+        uint16_t* shown = &drawn[y * fb_columns];
+        int cursor_row = moved && (y == old_cursor / fb_columns || y == cursor_cell / fb_columns);
+        if (drawn_valid && !cursor_row && row_equal(cells_row, shown)) continue;
+
+        for (size_t x = 0; x < fb_columns; x++) {
+            size_t i = y * fb_columns + x;
+            if (drawn_valid && cells_row[x] == shown[x] && !(moved && (i == old_cursor || i == cursor_cell))) continue;
+            fb_blit(x, y, cells_row[x], i == cursor_cell);
+            shown[x] = cells_row[x];
+            count++;
+        }
+    }
+    drawn_cursor = cursor_cell;
+    drawn_valid = 1;
+
+    fb_stats.frames++;
+    fb_stats.glyphs += count;
+    fb_stats.last = count;
+}
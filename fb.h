@@ -0,0 +1,51 @@
+#ifndef FB_H
+#define FB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "multiboot.h"
+
+/* Console framebuffer : les cellules de la VRAM texte (caractere + attribut VGA) sont dessinees avec la police
+   bitmap (font.c) dans le framebuffer lineaire que le bootloader a mis en place (make FRAMEBUFFER=1).
+   Chaque cellule fait 8x16 pixels : 1024x768 donne 48 lignes de 128 colonnes (au plus VGA_MAX_ROWS x VGA_MAX_COLUMNS,
+   le reste est une marge). Seules les cellules qui ont change depuis le dernier dessin sont redessinees */
+
+#define FB_CELL_WIDTH 8
+#define FB_CELL_HEIGHT 16 // une ligne du glyphe 8x8 couvre deux lignes de pixels
+
+/* Mode graphique : 32 bits par pixel */
+typedef struct {
+    uint8_t* base;          // premier pixel
+    uint32_t pitch;         // octets entre deux lignes de pixels
+    uint32_t width;         // en pixels
+    uint32_t height;
+    uint8_t red_position;   // bit de poids faible de chaque composante dans le pixel
+    uint8_t red_size;       // et sa largeur en bits
+    uint8_t green_position;
+    uint8_t green_size;
+    uint8_t blue_position;
+    uint8_t blue_size;
+} FbMode;
+
+/* Compteurs de dessin */
+typedef struct {
+    uint32_t frames;   // appels a fb_draw()
+    uint32_t glyphs;   // total de cellules redessinees
+    uint32_t last;     // cellules redessinees au dernier appel
+} FbStats;
+
+extern FbStats fb_stats;
+
+/* Lit le mode donne par GRUB. 0 si le bootloader n'a pas mis de framebuffer RGB 32 bits (mode texte) */
+int fb_mode_from_multiboot(const MultibootInfo* info, FbMode* mode);
+
+/* Prepare la palette et les masques, efface l'ecran. Retourne le nombre de lignes de texte affichables
+   (VGA_HEIGHT a VGA_MAX_ROWS) et leur largeur dans columns (VGA_WIDTH a VGA_MAX_COLUMNS), 0 si le mode est trop petit
+   pour 80x25 */
+size_t fb_init(const FbMode* mode, size_t* columns);
+
+/* Dessine la vue : les lignes de columns cellules de vram a partir de la cellule start (adresse de debut CRTC), et le
+   curseur en soulignement a la cellule cursor (cache s'il est hors de la vue) */
+void fb_draw(const uint16_t* vram, uint16_t start, uint16_t cursor);
+
+#endif
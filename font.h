@@ -0,0 +1,15 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+/* Police bitmap de la console framebuffer (fb.c), indexee en code page 437 comme la VGA.
+   8x8 pixels par glyphe, un octet par ligne, bit 7 = pixel de gauche. Seuls l'ASCII imprimable et les caracteres
+   des layouts (keyboard.c) sont dessines : les autres codes s'affichent vides */
+
+#define FONT_WIDTH 8
+#define FONT_HEIGHT 8
+
+extern const uint8_t font_8x8[256][FONT_HEIGHT];
+
+#endif
@@ -0,0 +1,274 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "history.h"
+#include "string.h"
+
+/* --- Format d'un record froid --- */
+/* [taille u16][nb caracteres u8][attribut de remplissage u8][nb spans u8] puis nb spans x (longueur u8, attribut u8)
+   puis les caracteres. Les cellules de fin de ligne (caractere 0, attribut de remplissage) ne sont pas stockees.
+   Un record ne coupe jamais la fin du ring : une taille 0 (ou moins de COLD_HEADER octets avant la fin) renvoie a 0 */
+#define COLD_HEADER 5
+#define COLD_RECORD_MAX (COLD_HEADER + 2 * HISTORY_MAX_WIDTH + HISTORY_MAX_WIDTH)
+
+/* Ligne froide decodee retournee par history_line() */
+static uint16_t cold_scratch[HISTORY_MAX_WIDTH];
+
+static inline uint16_t record_size(const uint8_t* record) {
+    return (uint16_t) (record[0] | record[1] << 8);
+}
+
+/* Offset reel d'un record : saute le bourrage de fin de ring */
+static inline uint32_t cold_skip_padding(History* history, uint32_t offset) {
+    if (history->cold_bytes - offset < COLD_HEADER || record_size(&history->cold[offset]) == 0) return 0;
+    return offset;
+}
+
+static uint32_t cold_encode(const uint16_t* line, size_t width, uint8_t* out) {
+    uint8_t fill = (uint8_t) (line[width - 1] >> 8);
+    uint32_t count = (uint32_t) width;
+    uint32_t spans = 0;
+
+    while (count > 0 && line[count - 1] == (uint16_t) (fill << 8)) count--;
+
+    uint8_t* span = out + COLD_HEADER;
+    for (uint32_t x = 0; x < count; ) {
+        uint8_t attribute = (uint8_t) (line[x] >> 8);
+        uint32_t run = 1;
+        while (x + run < count && (uint8_t) (line[x + run] >> 8) == attribute) run++;
+        span[2 * spans] = (uint8_t) run;
+        span[2 * spans + 1] = attribute;
+        spans++;
+        x += run;
+    }
+
+    uint8_t* chars = span + 2 * spans;
+    for (uint32_t x = 0; x < count; x++) chars[x] = (uint8_t) (line[x] & 0xFF);
+
+    uint32_t size = COLD_HEADER + 2 * spans + count;
+    out[0] = (uint8_t) (size & 0xFF);
+    out[1] = (uint8_t) (size >> 8);
+    out[2] = (uint8_t) count;
+    out[3] = fill;
+    out[4] = (uint8_t) spans;
+    return size;
+}
+
+static void cold_decode(const uint8_t* record, uint16_t* dst, size_t width) {
+    uint32_t count = record[2];
+    uint32_t spans = record[4];
+    const uint8_t* span = record + COLD_HEADER;
+    const uint8_t* chars = span + 2 * spans;
+    uint32_t x = 0;
+
+    for (uint32_t i = 0; i < spans; i++) {
+        uint16_t attribute = (uint16_t) (span[2 * i + 1] << 8);
+        for (uint32_t end = x + span[2 * i]; x < end; x++) dst[x] = attribute | chars[x];
+    }
+    memset16(dst + count, (uint16_t) (record[3] << 8), width - count);
+}
+
+/* Record de la ligne froide de numero absolu line : depuis le point de reprise du groupe (ou la plus ancienne ligne
+   si ce point a ete recycle), au plus HISTORY_CHECKPOINT - 1 records a sauter */
+static const uint8_t* cold_record(History* history, uint32_t line) {
+    uint32_t group = line - line % HISTORY_CHECKPOINT;
+    uint32_t at, offset;
+
+    if ((int32_t) (group - history->first_line) < 0) {
+        at = history->first_line;
+        offset = history->cold_tail;
+    } else {
+        at = group;
+        offset = history->checkpoints[(group / HISTORY_CHECKPOINT) % history->checkpoint_count];
+    }
+    offset = cold_skip_padding(history, offset);
+    for (; at != line; at++) {
+        offset += record_size(&history->cold[offset]);
+        if (offset == history->cold_bytes) offset = 0;
+        offset = cold_skip_padding(history, offset);
+    }
+    return &history->cold[offset];
+}
+
+/* Oublie la plus ancienne ligne froide */
+static void cold_drop_oldest(History* history) {
+    uint32_t offset = history->cold_tail;
+
+    if (cold_skip_padding(history, offset) != offset) {
+        history->cold_used -= history->cold_bytes - offset;
+        offset = 0;
+    }
+    uint32_t size = record_size(&history->cold[offset]);
+    history->cold_used -= size;
+    offset += size;
+    history->cold_tail = (offset == history->cold_bytes) ? 0 : offset;
+    history->cold_count--;
+    history->first_line++;
+}
+
+/* Ajoute une ligne en fin de store froid. Retourne le nombre de lignes froides oubliees pour lui faire de la place */
+static size_t cold_append(History* history, const uint16_t* line) {
+    uint8_t record[COLD_RECORD_MAX];
+    uint32_t size = cold_encode(line, history->width, record);
+    size_t dropped = 0;
+
+    if (history->cold_count == history->cold_max_lines) {
+        cold_drop_oldest(history);
+        dropped++;
+    }
+    while (1) {
+        uint32_t padding = (history->cold_bytes - history->cold_head < size) ? history->cold_bytes - history->cold_head : 0;
+        if (history->cold_count == 0) {
+            history->cold_head = history->cold_tail = history->cold_used = 0;
+            break;
+        }
+        if (history->cold_bytes - history->cold_used >= padding + size) {
+            if (padding) {
+                if (padding >= COLD_HEADER) history->cold[history->cold_head] = history->cold[history->cold_head + 1] = 0;
+                history->cold_used += padding;
+                history->cold_head = 0;
+            }
+            break;
+        }
+        cold_drop_oldest(history);
+        dropped++;
+    }
+
+    uint32_t line_number = history->first_line + history->cold_count;
+    if (line_number % HISTORY_CHECKPOINT == 0) {
+        history->checkpoints[(line_number / HISTORY_CHECKPOINT) % history->checkpoint_count] = history->cold_head;
+    }
+    memcpy(&history->cold[history->cold_head], record, size);
+    history->cold_head += size;
+    if (history->cold_head == history->cold_bytes) history->cold_head = 0;
+    history->cold_used += size;
+    history->cold_count++;
+    return dropped;
+}
+
+/* --- Lignes chaudes --- */
+static inline size_t hot_physical_row(History* history, size_t row) {
+    size_t physical = history->hot_head + (row - history->cold_count);
+    if (physical >= history->hot_lines) physical -= history->hot_lines;
+    return physical;
+}
+
+static inline uint16_t* hot_line(History* history, size_t physical) {
+    return &history->hot[physical * history->width];
+}
+
+/* Les lignes chaudes ne sont remplies avec blank qu'a leur premier usage : history_init ne touche a aucune cellule.
+   Les lignes physiques [0, hot_ready) sont initialisees, celles au dela valent blank sans etre ecrites */
+static uint16_t* hot_line_ready(History* history, size_t physical) {
+    if (physical >= history->hot_ready) {
+        memset16(hot_line(history, history->hot_ready), history->blank,
+                 (physical + 1 - history->hot_ready) * history->width);
+        history->hot_ready = physical + 1;
+    }
+    return hot_line(history, physical);
+}
+
+void history_init(History* history, void* storage, size_t lines, size_t width, uint16_t blank) {
+    uint8_t* next = (uint8_t*) storage;
+
+    history->width = width;
+    history->hot_lines = HISTORY_HOT_FOR(lines);
+    history->hot_head = 0;
+    history->hot = (uint16_t*) next;
+    next += history->hot_lines * width * sizeof(uint16_t);
+    history->dirty = (uint32_t*) next;
+    next += (history->hot_lines + 31) / 32 * sizeof(uint32_t);
+
+    history->cold_max_lines = HISTORY_COLD_FOR(lines);
+    history->cold_bytes = history->cold_max_lines * HISTORY_COLD_LINE_BYTES;
+    history->checkpoint_count = history->cold_max_lines / HISTORY_CHECKPOINT + 2;
+    history->cold = next;
+    next += history->cold_bytes;
+    history->checkpoints = (uint32_t*) next;
+    /* Un store trop petit pour deux lignes pleines ne sert a rien */
+    if (history->cold_bytes < 2 * COLD_RECORD_MAX) history->cold_max_lines = 0;
+
+    history->cold_count = 0;
+    history->cold_head = history->cold_tail = history->cold_used = 0;
+    history->first_line = 0;
+    history->cold_dirty_first = history->cold_dirty_end = 0;
+
+    /* Aucune ligne chaude n'est remplie ici (voir hot_line_ready) */
+    history->blank = blank;
+    history->hot_ready = 0;
+    history_clear_dirty(history);
+}
+
+uint16_t* history_line(History* history, size_t row) {
+    if (row < history->cold_count) {
+        cold_decode(cold_record(history, history->first_line + row), cold_scratch, history->width);
+        return cold_scratch;
+    }
+    return hot_line_ready(history, hot_physical_row(history, row));
+}
+
+const uint16_t* history_peek(History* history, size_t row) {
+    if (row < history->cold_count) {
+        cold_decode(cold_record(history, history->first_line + row), cold_scratch, history->width);
+        return cold_scratch;
+    }
+    size_t physical = hot_physical_row(history, row);
+    return (physical < history->hot_ready) ? hot_line(history, physical) : NULL;
+}
+
+void history_copy_line(History* history, size_t row, uint16_t* dst) {
+    if (row < history->cold_count) {
+        cold_decode(cold_record(history, history->first_line + row), dst, history->width);
+    } else {
+        size_t physical = hot_physical_row(history, row);
+        /* Une ligne jamais ecrite est rendue sans etre initialisee */
+        if (physical >= history->hot_ready) memset16(dst, history->blank, history->width);
+        else memcpy(dst, hot_line(history, physical), history->width * sizeof(uint16_t));
+    }
+}
+
+size_t history_push(History* history, uint16_t blank) {
+    size_t oldest = history->hot_head;
+    size_t dropped;
+
+    if (history->cold_max_lines == 0) {
+        /* Pas de store froid : la ligne est perdue, toutes les lignes logiques reculent */
+        history->first_line++;
+        dropped = 1;
+    } else {
+        uint32_t line_number = history->first_line + history->cold_count;
+        int was_dirty = (history->dirty[oldest / 32] >> (oldest % 32)) & 1;
+
+        dropped = cold_append(history, hot_line_ready(history, oldest));
+        /* Pas encore rendue : elle doit l'etre depuis le store froid */
+        if (was_dirty) {
+            if (history->cold_dirty_first == history->cold_dirty_end) history->cold_dirty_first = line_number;
+            history->cold_dirty_end = line_number + 1;
+        }
+    }
+
+    /* La ligne physique liberee devient la nouvelle derniere ligne chaude */
+    history->hot_head = (oldest + 1 == history->hot_lines) ? 0 : oldest + 1;
+    memset16(hot_line_ready(history, oldest), blank, history->width);
+    history->dirty[oldest / 32] |= 1u << (oldest % 32);
+    return dropped;
+}
+
+void history_mark_dirty(History* history, size_t row) {
+    if (row < history->cold_count) return;
+    size_t physical = hot_physical_row(history, row);
+    history->dirty[physical / 32] |= 1u << (physical % 32);
+}
+
+int history_row_dirty(History* history, size_t row) {
+    if (row < history->cold_count) {
+        uint32_t line_number = history->first_line + row;
+        return (int32_t) (line_number - history->cold_dirty_first) >= 0 && (int32_t) (line_number - history->cold_dirty_end) < 0;
+    }
+    size_t physical = hot_physical_row(history, row);
+    return (history->dirty[physical / 32] >> (physical % 32)) & 1;
+}
+
+void history_clear_dirty(History* history) {
+    memset(history->dirty, 0, (history->hot_lines + 31) / 32 * sizeof(uint32_t));
+    history->cold_dirty_first = history->cold_dirty_end = 0;
+}
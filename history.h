@@ -0,0 +1,84 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Historique d'un screen en deux niveaux :
+   - les lignes chaudes (les HISTORY_HOT_LINES plus recentes) restent en cellules brutes : c'est la que le curseur
+     ecrit et que la saisie s'edite
+   - les lignes plus anciennes passent dans un store froid compresse (attributs en RLE, caracteres sans les blancs
+     de fin de ligne) et ne sont decodees que pour etre affichees
+   Les lignes sont numerotees logiquement : 0 = la plus ancienne encore presente, puis les froides, puis les chaudes. */
+
+#define HISTORY_MAX_WIDTH 128 // cellules par ligne au plus (la largeur de la vue, fixee a history_init)
+#define HISTORY_HOT_LINES 128
+#define HISTORY_COLD_LINE_BYTES 48 // budget moyen du store froid par ligne (une ligne de texte courte tient en 20-50 octets)
+#define HISTORY_CHECKPOINT 16      // une position memorisee toutes les 16 lignes froides
+
+#define HISTORY_HOT_FOR(lines) ((size_t) (lines) < HISTORY_HOT_LINES ? (size_t) (lines) : HISTORY_HOT_LINES)
+#define HISTORY_COLD_FOR(lines) ((size_t) (lines) - HISTORY_HOT_FOR(lines))
+
+/* Octets de stockage pour un historique de lines lignes de width cellules : cellules chaudes, bits sales, store froid,
+   points de reprise. Le budget froid ne depend pas de la largeur (les fins de ligne vides ne sont pas stockees) */
+#define HISTORY_STORAGE_SIZE(lines, width) \
+    (HISTORY_HOT_FOR(lines) * (size_t) (width) * sizeof(uint16_t) \
+     + (HISTORY_HOT_FOR(lines) + 31) / 32 * sizeof(uint32_t) \
+     + HISTORY_COLD_FOR(lines) * HISTORY_COLD_LINE_BYTES \
+     + (HISTORY_COLD_FOR(lines) / HISTORY_CHECKPOINT + 2) * sizeof(uint32_t))
+
+typedef struct {
+    /* Lignes chaudes : ring de hot_lines lignes brutes */
+    uint16_t* hot;
+    uint32_t* dirty;          // 1 bit par ligne chaude physique, modifiee depuis le dernier rendu
+    size_t hot_lines;
+    size_t hot_head;          // ligne physique de la plus ancienne ligne chaude
+    size_t hot_ready;         // lignes physiques [0, hot_ready) deja remplies (les suivantes valent blank)
+    size_t width;             // cellules par ligne (chaude ou decodee), au plus HISTORY_MAX_WIDTH
+    uint16_t blank;           // cellule vide de l'ecran
+
+    /* Lignes froides : ring d'octets de records compresses, jamais modifies */
+    uint8_t* cold;
+    uint32_t* checkpoints;    // offset du record des lignes dont le numero absolu est multiple de HISTORY_CHECKPOINT
+    size_t cold_bytes;
+    size_t cold_max_lines;    // 0 : pas de store froid, la plus ancienne ligne chaude est perdue
+    size_t checkpoint_count;
+    uint32_t cold_count;
+    uint32_t cold_head;       // offset ou ecrire le prochain record
+    uint32_t cold_tail;       // offset du record de la plus ancienne ligne
+    uint32_t cold_used;       // octets occupes (bourrage de fin de ring compris)
+
+    uint32_t first_line;      // numero absolu de la ligne logique 0 (avance quand la plus ancienne ligne est perdue)
+    uint32_t cold_dirty_first, cold_dirty_end; // lignes (numeros absolus) passees froides avant d'avoir ete rendues
+} History;
+
+/* Decoupe storage (HISTORY_STORAGE_SIZE(lines, width) octets). Les lignes chaudes valent blank mais ne sont remplies
+   qu'a leur premier acces en ecriture (history_line, history_push) : l'initialisation ne coute rien */
+void history_init(History* history, void* storage, size_t lines, size_t width, uint16_t blank);
+
+/* Nombre de lignes logiques (froides + chaudes) */
+static inline size_t history_rows(const History* history) {
+    return history->cold_count + history->hot_lines;
+}
+
+/* Ligne logique row : pointeur modifiable pour une ligne chaude, copie decodee en lecture seule pour une ligne froide
+   (valable jusqu'au prochain appel) */
+uint16_t* history_line(History* history, size_t row);
+
+/* Lecture seule de la ligne logique row : les cellules chaudes en place, une ligne froide decodee dans un tampon
+   interne (valable jusqu'au prochain appel), NULL pour une ligne chaude jamais ecrite (elle vaut blank) */
+const uint16_t* history_peek(History* history, size_t row);
+
+/* Recopie (ou decode) la ligne logique row dans dst (width cellules) */
+void history_copy_line(History* history, size_t row, uint16_t* dst);
+
+/* Libere une ligne en bas : la plus ancienne ligne chaude passe froide (ou est perdue sans store froid) et la nouvelle
+   derniere ligne est remplie avec blank. Retourne le nombre de lignes perdues en haut : les lignes logiques de
+   l'appelant reculent d'autant */
+size_t history_push(History* history, uint16_t blank);
+
+void history_mark_dirty(History* history, size_t row);
+int history_row_dirty(History* history, size_t row);
+void history_clear_dirty(History* history);
+
+#endif
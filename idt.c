@@ -0,0 +1,139 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "io.h"
+#include "idt.h"
+#include "printk.h"
+#include "smp.h"
+
+/* --- Port mapping --- */
+static const uint16_t PIC1_COMMAND = 0x20; // PIC maitre : commandes (ICW1, EOI, lecture ISR)
+static const uint16_t PIC1_DATA    = 0x21; // PIC maitre : masque des IRQ 0-7
+static const uint16_t PIC2_COMMAND = 0xA0; // PIC esclave : commandes
+static const uint16_t PIC2_DATA    = 0xA1; // PIC esclave : masque des IRQ 8-15
+
+/* --- Constantes --- */
+static const uint8_t PIC_EOI = 0x20;       // End Of Interrupt
+static const uint8_t PIC_READ_ISR = 0x0B;  // OCW3 : lire l'In-Service Register
+static const uint8_t IRQ_BASE = 32;        // Les IRQ commencent apres les 32 exceptions du CPU
+static const uint16_t KERNEL_CODE_SELECTOR = 0x08; // Segment code de la GDT (boot.S)
+static const uint8_t GATE_INTERRUPT_RING0 = 0x8E;  // present, ring 0, interrupt gate 32-bit (IF coupe a l'entree)
+
+/* Entree de l'IDT (format imposee par le CPU) */
+typedef struct {
+    uint16_t offset_low;
+    uint16_t selector;
+    uint8_t  zero;
+    uint8_t  type_attr;
+    uint16_t offset_high;
+} __attribute__((packed)) IdtEntry;
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) IdtPointer;
+
+IdtEntry idt[256];
+static irq_handler_t irq_handlers[16];
+
+/* Adresses des stubs (isr.S) : 32 exceptions puis 16 IRQ, puis les deux vecteurs du local APIC */
+extern uint32_t isr_stub_table[48];
+extern uint32_t lapic_stub_table[2];
+
+static const char* exception_names[32] = {
+    "Divide Error", "Debug", "NMI", "Breakpoint", "Overflow", "Bound Range", "Invalid Opcode", "Device Not Available",
+    "Double Fault", "Coprocessor Segment", "Invalid TSS", "Segment Not Present", "Stack Fault", "General Protection",
+    "Page Fault", "Reserved", "x87 FPU Error", "Alignment Check", "Machine Check", "SIMD Exception",
+    "Virtualization", "Control Protection", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved",
+    "Hypervisor Injection", "VMM Communication", "Security", "Reserved",
+};
+
+static void idt_set_gate(uint8_t vector, uint32_t handler) {
+    idt[vector].offset_low = handler & 0xFFFF;
+    idt[vector].selector = KERNEL_CODE_SELECTOR;
+    idt[vector].zero = 0;
+    idt[vector].type_attr = GATE_INTERRUPT_RING0;
+    idt[vector].offset_high = (handler >> 16) & 0xFFFF;
+}
+
+/* Reprogramme les deux 8259 : par defaut les IRQ 0-7 tombent sur les vecteurs 8-15 qui sont ceux des exceptions du CPU */
+static void pic_remap(void) {
+    outb(PIC1_COMMAND, 0x11); io_wait(); // ICW1 : init + ICW4 attendu
+    outb(PIC2_COMMAND, 0x11); io_wait();
+    outb(PIC1_DATA, IRQ_BASE); io_wait();     // ICW2 : vecteur de base du maitre
+    outb(PIC2_DATA, IRQ_BASE + 8); io_wait(); // ICW2 : vecteur de base de l'esclave
+    outb(PIC1_DATA, 0x04); io_wait(); // ICW3 : esclave branche sur l'IRQ2 du maitre
+    outb(PIC2_DATA, 0x02); io_wait(); // ICW3 : identite de l'esclave
+    outb(PIC1_DATA, 0x01); io_wait(); // ICW4 : mode 8086
+    outb(PIC2_DATA, 0x01); io_wait();
+
+    /* Tout est masque sauf la cascade (IRQ2), irq_register() demasque au besoin */
+    outb(PIC1_DATA, 0xFB);
+    outb(PIC2_DATA, 0xFF);
+}
+
+static void pic_unmask(uint8_t irq) {
+    uint16_t port = (irq < 8) ? PIC1_DATA : PIC2_DATA;
+    uint8_t bit = irq % 8;
+    outb(port, inb(port) & ~(1 << bit));
+}
+
+/* Lit l'In-Service Register pour detecter les IRQ 7/15 parasites (le PIC les signale sans IRQ reelle) */
+static uint8_t pic_read_isr(uint16_t command_port) {
+    outb(command_port, PIC_READ_ISR);
+    return inb(command_port);
+}
+
+void idt_init(void) {
+    pic_remap();
+    for (size_t i = 0; i < 48; i++) {
+        idt_set_gate(i, isr_stub_table[i]);
+    }
+    idt_set_gate(LAPIC_WAKE_VECTOR, lapic_stub_table[0]);
+    idt_set_gate(LAPIC_SPURIOUS_VECTOR, lapic_stub_table[1]);
+    idt_load();
+}
+
+void idt_load(void) {
+    IdtPointer pointer = { sizeof(idt) - 1, (uint32_t) idt };
+    __asm__ volatile ("lidt %0" : : "m"(pointer));
+}
+
+void irq_register(uint8_t irq, irq_handler_t handler) {
+    irq_handlers[irq] = handler;
+    pic_unmask(irq);
+}
+
+/* Une exception CPU dans le kernel est fatale : on l'affiche et on arrete le CPU */
+static void exception_panic(InterruptFrame* frame) {
+    printk(KERN_EMERG "\nEXCEPTION %d (%s) err=%x eip=%x\n", frame->vector, exception_names[frame->vector], frame->error_code, frame->eip);
+    /* Plus de boucle principale pour drainer le log : on l'affiche tout de suite. Sur un AP le message est dans sa
+       file de sortie, c'est le BSP (seul a toucher la console) qui l'affichera */
+    if (smp_cpu_index() == 0) console_flush();
+    while (1) __asm__ volatile ("cli; hlt");
+}
+
+/* Appele par isr_common (isr.S) pour toutes les interruptions */
+void isr_dispatch(InterruptFrame* frame) {
+    if (frame->vector < IRQ_BASE) {
+        exception_panic(frame);
+        return;
+    }
+    if (frame->vector >= LAPIC_VECTOR_BASE) {
+        smp_interrupt(frame->vector);
+        return;
+    }
+
+    uint8_t irq = frame->vector - IRQ_BASE;
+
+    /* IRQ parasite : pas d'EOI sur le PIC concerne (il n'a rien en service) */
+    if (irq == 7 && !(pic_read_isr(PIC1_COMMAND) & 0x80)) return;
+    if (irq == 15 && !(pic_read_isr(PIC2_COMMAND) & 0x80)) {
+        outb(PIC1_COMMAND, PIC_EOI); // le maitre a quand meme vu la cascade
+        return;
+    }
+
+    if (irq_handlers[irq]) irq_handlers[irq](frame);
+
+    if (irq >= 8) outb(PIC2_COMMAND, PIC_EOI);
+    outb(PIC1_COMMAND, PIC_EOI);
+}
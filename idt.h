@@ -0,0 +1,52 @@
+#ifndef IDT_H
+#define IDT_H
+
+#include <stdint.h>
+
+/* Etat de la pile a l'entree de isr_dispatch (voir isr_common dans isr.S), du plus bas au plus haut */
+typedef struct {
+    uint32_t gs, fs, es, ds;
+    uint32_t edi, esi, ebp, esp, ebx, edx, ecx, eax; // pusha
+    uint32_t vector, error_code;                     // pousses par le stub
+    uint32_t eip, cs, eflags;                        // pousses par le CPU
+} InterruptFrame;
+
+typedef void (*irq_handler_t)(InterruptFrame* frame);
+
+/* Remappe le PIC (IRQ 0-15 -> vecteurs 32-47, toutes masquees) et charge l'IDT */
+void idt_init(void);
+
+/* Charge l'IDT deja remplie par idt_init() (les APs partagent celle du BSP, smp.c) */
+void idt_load(void);
+
+/* Installe le handler d'une IRQ et la demasque sur le PIC. L'EOI est envoye par le dispatcher */
+void irq_register(uint8_t irq, irq_handler_t handler);
+
+static inline void interrupts_enable(void) {
+    __asm__ volatile ("sti" ::: "memory");
+}
+
+static inline void interrupts_disable(void) {
+    __asm__ volatile ("cli" ::: "memory");
+}
+
+/* Section critique courte : coupe les interruptions et retourne l'etat precedent de EFLAGS pour irq_restore() */
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    __asm__ volatile ("pushf\n\tpop %0\n\tcli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+/* Reactive les interruptions seulement si elles l'etaient avant irq_save() (bit IF = 0x200) */
+static inline void irq_restore(uint32_t flags) {
+    if (flags & 0x200) __asm__ volatile ("sti" ::: "memory");
+}
+
+/* Active les interruptions et dort jusqu'a la prochaine.
+   sti ne prend effet qu'apres l'instruction suivante : une IRQ arrivee apres le test fait par l'appelant
+   (interruptions coupees) reveille donc forcement le hlt, aucun reveil n'est perdu */
+static inline void cpu_wait_for_interrupt(void) {
+    __asm__ volatile ("sti; hlt" ::: "memory");
+}
+
+#endif
@@ -23,4 +23,12 @@ static inline uint8_t inb(uint16_t port)
     return ret;
 }
 
+/*
+ * io_wait: Attend ~1us en ecrivant sur un port inutilise (0x80), laisse le temps aux vieux controleurs (PIC) de suivre
+ */
+static inline void io_wait(void)
+{
+    outb(0x80, 0);
+}
+
 #endif
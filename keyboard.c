@@ -0,0 +1,231 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "keyboard.h"
+#include "string.h"
+
+/* Layouts : une entree par make code set 1. Les caracteres hors ASCII sont en code page 437 (celle de la VGA) */
+
+static const KeyboardLayout layout_us = {
+    .name = "us",
+    .normal = {
+        [0x01] = 27,
+        [0x02] = '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b', '\t',
+        [0x10] = 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n',
+        [0x1E] = 'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`',
+        [0x2B] = '\\', 'z', 'x', 'c', 'v', 'b', 'n', 'm', ',', '.', '/',
+        [0x37] = '*', [0x39] = ' ', [0x4A] = '-', [0x4E] = '+', [0x56] = '\\',
+    },
+    .shifted = {
+        [0x01] = 27,
+        [0x02] = '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '_', '+', '\b', '\t',
+        [0x10] = 'Q', 'W', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', '{', '}', '\n',
+        [0x1E] = 'A', 'S', 'D', 'F', 'G', 'H', 'J', 'K', 'L', ':', '"', '~',
+        [0x2B] = '|', 'Z', 'X', 'C', 'V', 'B', 'N', 'M', '<', '>', '?',
+        [0x37] = '*', [0x39] = ' ', [0x4A] = '-', [0x4E] = '+', [0x56] = '|',
+    },
+    .altgr = { 0 },
+};
+
+/* AZERTY : e accent aigu 0x82, e grave 0x8A, c cedille 0x87, a grave 0x85, u grave 0x97, degre 0xF8,
+   livre 0x9C, carre 0xFD, micro 0xE6, paragraphe 0x15 */
+static const KeyboardLayout layout_fr = {
+    .name = "fr",
+    .normal = {
+        [0x01] = 27,
+        [0x02] = '&', 0x82, '"', '\'', '(', '-', 0x8A, '_', 0x87, 0x85, ')', '=', '\b', '\t',
+        [0x10] = 'a', 'z', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '^', '$', '\n',
+        [0x1E] = 'q', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', 'm', 0x97, 0xFD,
+        [0x2B] = '*', 'w', 'x', 'c', 'v', 'b', 'n', ',', ';', ':', '!',
+        [0x37] = '*', [0x39] = ' ', [0x4A] = '-', [0x4E] = '+', [0x56] = '<',
+    },
+    .shifted = {
+        [0x01] = 27,
+        [0x02] = '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', 0xF8, '+', '\b', '\t',
+        [0x10] = 'A', 'Z', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', 0, 0x9C, '\n',
+        [0x1E] = 'Q', 'S', 'D', 'F', 'G', 'H', 'J', 'K', 'L', 'M', '%', 0,
+        [0x2B] = 0xE6, 'W', 'X', 'C', 'V', 'B', 'N', '?', '.', '/', 0x15,
+        [0x37] = '*', [0x39] = ' ', [0x4A] = '-', [0x4E] = '+', [0x56] = '>',
+    },
+    .altgr = {
+        [0x03] = '~', '#', '{', '[', '|', '`', '\\', '^', '@', ']', '}',
+    },
+};
+
+static const KeyboardLayout* const layouts[] = { &layout_us, &layout_fr };
+#define LAYOUT_COUNT (sizeof(layouts) / sizeof(layouts[0]))
+
+const char* const keyboard_layout_names[] = { "us", "fr", NULL };
+
+/* Bits internes des modificateurs tenus : gauche et droite sont suivis separement pour qu'en relacher un
+   ne fasse pas oublier l'autre */
+#define HELD_LSHIFT 0x01
+#define HELD_RSHIFT 0x02
+#define HELD_LCTRL  0x04
+#define HELD_RCTRL  0x08
+#define HELD_LALT   0x10
+#define HELD_ALTGR  0x20
+
+static const uint8_t held_bits[256] = {
+    [KEY_LSHIFT] = HELD_LSHIFT, [KEY_RSHIFT] = HELD_RSHIFT,
+    [KEY_LCTRL] = HELD_LCTRL,   [KEY_RCTRL] = HELD_RCTRL,
+    [KEY_LALT] = HELD_LALT,     [KEY_ALTGR] = HELD_ALTGR,
+};
+
+static const uint8_t lock_bits[256] = {
+    [KEY_CAPS_LOCK] = KEY_MOD_CAPS, [KEY_NUM_LOCK] = KEY_MOD_NUM, [KEY_SCROLL_LOCK] = KEY_MOD_SCROLL,
+};
+
+/* Pave numerique sans Num Lock : memes codes que les touches de navigation E0.
+   Avec Num Lock : chiffres (independants du layout) */
+static const uint8_t keypad_navigation[KEY_KP_LAST - KEY_KP_FIRST + 1] = {
+    KEY_HOME, KEY_UP, KEY_PAGE_UP, 0, KEY_LEFT, 0, KEY_RIGHT, 0, KEY_END, KEY_DOWN, KEY_PAGE_DOWN, KEY_INSERT,
+    KEY_DELETE,
+};
+static const char keypad_digits[] = "789-456+1230.";
+
+/* Etat de la machine : prefixe en attente */
+enum {
+    DECODE_NORMAL,
+    DECODE_E0,    // le prochain octet est une touche etendue
+    DECODE_E1,    // sequence Pause : les octets suivants sont ignores
+};
+#define PAUSE_TAIL 5 // octets qui suivent E1 dans E1 1D 45 E1 9D C5
+
+static struct {
+    const KeyboardLayout* layout;
+    uint8_t state;
+    uint8_t skip;       // octets restants de la sequence Pause
+    uint8_t held;       // HELD_*
+    uint8_t locks;      // KEY_MOD_CAPS / NUM / SCROLL
+    uint32_t down[8];   // touches enfoncees, pour reconnaitre la repetition typematique
+} decoder = { .layout = &layout_us };
+
+KeyboardStats keyboard_stats;
+
+void keyboard_reset(void) {
+    memset(&decoder, 0, sizeof(decoder));
+    decoder.layout = &layout_us;
+    memset(&keyboard_stats, 0, sizeof(keyboard_stats));
+}
+
+uint8_t keyboard_modifiers(void) {
+    uint8_t modifiers = decoder.locks;
+    if (decoder.held & (HELD_LSHIFT | HELD_RSHIFT)) modifiers |= KEY_MOD_SHIFT;
+    if (decoder.held & (HELD_LCTRL | HELD_RCTRL)) modifiers |= KEY_MOD_CTRL;
+    if (decoder.held & HELD_LALT) modifiers |= KEY_MOD_ALT;
+    if (decoder.held & HELD_ALTGR) modifiers |= KEY_MOD_ALTGR;
+    return modifiers;
+}
+
+/* Caractere d'une touche (code deja traduit pour le pave numerique) selon le layout et les modificateurs */
+static uint8_t key_ascii(uint8_t key, uint8_t code, uint8_t modifiers) {
+    if (key == KEY_KP_ENTER) return '\n';
+    if (key == KEY_KP_SLASH) return '/';
+    if (key & 0x80) return 0;
+    if (code >= KEY_KP_FIRST && code <= KEY_KP_LAST && (modifiers & KEY_MOD_NUM)) {
+        return (uint8_t) keypad_digits[code - KEY_KP_FIRST];
+    }
+
+    const KeyboardLayout* layout = decoder.layout;
+    if (modifiers & KEY_MOD_ALTGR) return layout->altgr[key];
+
+    uint8_t base = layout->normal[key];
+    int letter = (base >= 'a' && base <= 'z');
+    if ((modifiers & KEY_MOD_CTRL) && letter) return (uint8_t) (base & 0x1F);
+
+    /* Caps Lock inverse Shift pour les lettres seulement */
+    int shift = (modifiers & KEY_MOD_SHIFT) != 0;
+    if ((modifiers & KEY_MOD_CAPS) && letter) shift = !shift;
+    return shift ? layout->shifted[key] : base;
+}
+
+int keyboard_decode(uint8_t scancode, uint64_t timestamp, KeyEvent* event) {
+    if (decoder.state == DECODE_E1) {
+        if (--decoder.skip == 0) decoder.state = DECODE_NORMAL;
+        keyboard_stats.ignored++;
+        return 0;
+    }
+
+    switch (scancode) {
+        case 0x00: case 0xFA: case 0xFE: case 0xFF: // erreur, ACK, resend, overrun : reponses du clavier
+            keyboard_stats.ignored++;
+            return 0;
+        case 0xE0:
+            decoder.state = DECODE_E0;
+            return 0;
+        case 0xE1:
+            decoder.state = DECODE_E1;
+            decoder.skip = PAUSE_TAIL;
+            keyboard_stats.ignored++;
+            return 0;
+    }
+
+    int extended = (decoder.state == DECODE_E0);
+    decoder.state = DECODE_NORMAL;
+    int release = (scancode & 0x80) != 0;
+    uint8_t code = scancode & 0x7F;
+
+    /* E0 2A / E0 36 : faux Shift que le clavier ajoute autour des touches etendues, sans signification */
+    if (extended && (code == KEY_LSHIFT || code == KEY_RSHIFT)) {
+        keyboard_stats.ignored++;
+        return 0;
+    }
+
+    uint8_t key = extended ? (uint8_t) (code | 0x80) : code;
+    uint32_t bit = 1u << (key & 31);
+    uint32_t* down = &decoder.down[key >> 5];
+    uint8_t flags = 0;
+
+    if (release) {
+        *down &= ~bit;
+        decoder.held &= (uint8_t) ~held_bits[key];
+        flags = KEY_EVENT_RELEASE;
+    } else {
+        if (*down & bit) {
+            flags = KEY_EVENT_REPEAT;
+            keyboard_stats.repeats++;
+        } else {
+            /* Les Lock basculent a l'appui, pas a la repetition */
+            decoder.locks ^= lock_bits[key];
+        }
+        *down |= bit;
+        decoder.held |= held_bits[key];
+    }
+
+    uint8_t modifiers = keyboard_modifiers();
+
+    /* Sans Num Lock, le pave numerique est un second jeu de fleches */
+    if (!extended && code >= KEY_KP_FIRST && code <= KEY_KP_LAST && !(modifiers & KEY_MOD_NUM)) {
+        uint8_t navigation = keypad_navigation[code - KEY_KP_FIRST];
+        if (navigation) key = navigation;
+    }
+
+    event->timestamp = timestamp;
+    event->key = key;
+    event->ascii = release ? 0 : key_ascii(key, code, modifiers);
+    event->modifiers = modifiers;
+    event->flags = flags;
+    keyboard_stats.events++;
+    return 1;
+}
+
+int keyboard_set_layout(const char* name) {
+    for (size_t i = 0; i < LAYOUT_COUNT; i++) {
+        if (strcmp(layouts[i]->name, name) == 0) {
+            decoder.layout = layouts[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const KeyboardLayout* keyboard_layout(void) {
+    return decoder.layout;
+}
+
+void keyboard_record_latency(uint32_t cycles) {
+    keyboard_stats.latency_count++;
+    keyboard_stats.latency_last = cycles;
+    keyboard_stats.latency_total += cycles;
+    if (cycles > keyboard_stats.latency_max) keyboard_stats.latency_max = cycles;
+}
@@ -1,45 +1,110 @@
 #ifndef KEYBOARD_H
 #define KEYBOARD_H
 
-/* mapping for US Keyboard */
-unsigned char kbdus[128] =
-{
-    0,  27, '1', '2', '3', '4', '5', '6', '7', '8',	/* 9 */
-  '9', '0', '-', '=', '\b',	/* Backspace */
-  '\t',			/* Tab */
-  'q', 'w', 'e', 'r',	/* 19 */
-  't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n',	/* Enter key */
-    0,			/* 29   - Control */
-  'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';',	/* 39 */
- '\'', '`',   0,		/* Left shift */
- '\\', 'z', 'x', 'c', 'v', 'b', 'n',			/* 49 */
-  'm', ',', '.', '/',   0,				/* Right shift */
-  '*',
-    0,	/* Alt */
-  ' ',	/* Space bar */
-    0,	/* Caps lock */
-    0,	/* 59 - F1 key ... > */
-    0,   0,   0,   0,   0,   0,   0,   0,
-    0,	/* < ... F10 */
-    0,	/* 69 - Num lock*/
-    0,	/* Scroll Lock */
-    0,	/* Home key */
-    0,	/* Up Arrow */
-    0,	/* Page Up */
-  '-',
-    0,	/* Left Arrow */
-    0,
-    0,	/* Right Arrow */
-  '+',
-    0,	/* 79 - End key*/
-    0,	/* Down Arrow */
-    0,	/* Page Down */
-    0,	/* Insert Key */
-    0,	/* Delete Key */
-    0,   0,   0,
-    0,	/* F11 Key */
-    0,	/* F12 Key */
-    0,	/* All other keys are undefined */
-};
+#include <stddef.h>
+#include <stdint.h>
+
+/* Decodeur du scancode set 1 : les octets recus par l'IRQ1 (ps2.c) deviennent des KeyEvent.
+   Le code d'une touche est sa position physique : le make code set 1, avec 0x80 en plus pour les codes prefixes
+   par 0xE0 (fleches, Home/End, AltGr, Ctrl droit...). Le caractere produit depend du layout et des modificateurs. */
+
+/* --- Codes de touches (make code set 1, | 0x80 si prefixe E0) --- */
+#define KEY_ESCAPE      0x01
+#define KEY_BACKSPACE   0x0E
+#define KEY_TAB         0x0F
+#define KEY_ENTER       0x1C
+#define KEY_LCTRL       0x1D
+#define KEY_LSHIFT      0x2A
+#define KEY_RSHIFT      0x36
+#define KEY_LALT        0x38
+#define KEY_CAPS_LOCK   0x3A
+#define KEY_F1          0x3B // F1 a F10 se suivent
+#define KEY_F10         0x44
+#define KEY_NUM_LOCK    0x45
+#define KEY_SCROLL_LOCK 0x46
+#define KEY_KP_FIRST    0x47 // pave numerique : 0x47 (7/Home) a 0x53 (./Del)
+#define KEY_KP_LAST     0x53
+#define KEY_F11         0x57
+#define KEY_F12         0x58
+#define KEY_KP_ENTER    0x9C
+#define KEY_RCTRL       0x9D
+#define KEY_KP_SLASH    0xB5
+#define KEY_ALTGR       0xB8
+#define KEY_HOME        0xC7
+#define KEY_UP          0xC8
+#define KEY_PAGE_UP     0xC9
+#define KEY_LEFT        0xCB
+#define KEY_RIGHT       0xCD
+#define KEY_END         0xCF
+#define KEY_DOWN        0xD0
+#define KEY_PAGE_DOWN   0xD1
+#define KEY_INSERT      0xD2
+#define KEY_DELETE      0xD3
+#define KEY_PAUSE       0xC5 // sequence E1 1D 45 E1 9D C5 (pas de relachement)
+
+/* --- Modificateurs (KeyEvent.modifiers) --- */
+#define KEY_MOD_SHIFT  0x01
+#define KEY_MOD_CTRL   0x02
+#define KEY_MOD_ALT    0x04
+#define KEY_MOD_ALTGR  0x08
+#define KEY_MOD_CAPS   0x10 // Caps Lock actif
+#define KEY_MOD_NUM    0x20 // Num Lock actif
+#define KEY_MOD_SCROLL 0x40 // Scroll Lock actif
+
+/* --- KeyEvent.flags --- */
+#define KEY_EVENT_RELEASE 0x01
+#define KEY_EVENT_REPEAT  0x02 // make code recu alors que la touche etait deja enfoncee (typematic)
+
+typedef struct {
+    uint64_t timestamp;  // TSC lu par l'IRQ1 a la capture du dernier octet (0 sans TSC)
+    uint8_t key;         // KEY_* ou make code
+    uint8_t ascii;       // caractere produit (layout + modificateurs, code page 437), 0 si aucun
+    uint8_t modifiers;   // KEY_MOD_* au moment de l'evenement
+    uint8_t flags;       // KEY_EVENT_*
+} KeyEvent;
+
+/* Layout : caractere produit par chaque make code (0x00-0x7F), sans modificateur, avec Shift et avec AltGr */
+#define KEYMAP_SIZE 128
+
+typedef struct {
+    const char* name;
+    unsigned char normal[KEYMAP_SIZE];
+    unsigned char shifted[KEYMAP_SIZE];
+    unsigned char altgr[KEYMAP_SIZE];
+} KeyboardLayout;
+
+/* Compteurs du clavier */
+typedef struct {
+    uint32_t events;          // evenements produits (appuis, repetitions et relachements)
+    uint32_t repeats;         // dont repetitions typematiques
+    uint32_t ignored;         // octets ignores (ACK/resend du clavier, faux Shift des sequences E0, Pause)
+    uint32_t batches;         // lots traites avec un seul rendu
+    uint32_t max_batch;       // plus gros lot (evenements)
+    uint32_t latency_count;   // appuis mesures de l'IRQ1 a la VRAM
+    uint32_t latency_last;    // en cycles TSC
+    uint32_t latency_max;
+    uint64_t latency_total;
+} KeyboardStats;
+
+extern KeyboardStats keyboard_stats;
+
+/* Oublie les touches enfoncees et les modificateurs, layout US */
+void keyboard_reset(void);
+
+/* Fait avancer la machine a etats d'un octet. Retourne 1 et remplit event si l'octet termine un evenement */
+int keyboard_decode(uint8_t scancode, uint64_t timestamp, KeyEvent* event);
+
+/* Modificateurs courants (KEY_MOD_*), par exemple pour les LEDs apres un Lock */
+uint8_t keyboard_modifiers(void);
+
+/* Change de layout ("us", "fr"). Retourne 0 si le nom est inconnu */
+int keyboard_set_layout(const char* name);
+const KeyboardLayout* keyboard_layout(void);
+
+/* Noms des layouts disponibles, termines par NULL */
+extern const char* const keyboard_layout_names[];
+
+/* Ajoute la latence d'un appui (cycles entre la capture et la fin du rendu) aux compteurs */
+void keyboard_record_latency(uint32_t cycles);
 
 #endif
@@ -0,0 +1,118 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "line.h"
+#include "string.h"
+
+/* Nombre de caracteres que peut contenir la ligne */
+#define LINE_CAPACITY (LINE_INPUT_MAX - 1)
+
+void line_init(LineEditor* line) {
+    line_reset(line);
+    line->history_count = 0;
+}
+
+void line_reset(LineEditor* line) {
+    line->gap_start = 0;
+    line->gap_end = LINE_CAPACITY;
+    line->browse = 0;
+}
+
+int line_insert(LineEditor* line, char c) {
+    if (line->gap_start == line->gap_end) return 0;
+    line->text[line->gap_start++] = c;
+    return 1;
+}
+
+int line_backspace(LineEditor* line) {
+    if (line->gap_start == 0) return 0;
+    line->gap_start--;
+    return 1;
+}
+
+int line_delete(LineEditor* line) {
+    if (line->gap_end == LINE_CAPACITY) return 0;
+    line->gap_end++;
+    return 1;
+}
+
+/* Le caractere qui passe de l'autre cote du curseur traverse le trou */
+int line_left(LineEditor* line) {
+    if (line->gap_start == 0) return 0;
+    line->text[--line->gap_end] = line->text[--line->gap_start];
+    return 1;
+}
+
+int line_right(LineEditor* line) {
+    if (line->gap_end == LINE_CAPACITY) return 0;
+    line->text[line->gap_start++] = line->text[line->gap_end++];
+    return 1;
+}
+
+void line_move(LineEditor* line, size_t pos) {
+    size_t len = line_length(line);
+    if (pos > len) pos = len;
+
+    /* Deplace d'un bloc les caracteres entre l'ancien et le nouveau curseur */
+    if (pos < line->gap_start) {
+        size_t count = line->gap_start - pos;
+        line->gap_end -= count;
+        line->gap_start = pos;
+        memmove(&line->text[line->gap_end], &line->text[pos], count);
+    } else if (pos > line->gap_start) {
+        size_t count = pos - line->gap_start;
+        memmove(&line->text[line->gap_start], &line->text[line->gap_end], count);
+        line->gap_start = pos;
+        line->gap_end += count;
+    }
+}
+
+void line_get(const LineEditor* line, char* out) {
+    size_t after = LINE_CAPACITY - line->gap_end;
+    memcpy(out, line->text, line->gap_start);
+    memcpy(out + line->gap_start, &line->text[line->gap_end], after);
+    out[line->gap_start + after] = '\0';
+}
+
+/* Remplace toute la ligne, curseur a la fin */
+static void line_set(LineEditor* line, const char* text) {
+    size_t len = strlen(text);
+    if (len > LINE_CAPACITY) len = LINE_CAPACITY;
+    memcpy(line->text, text, len);
+    line->gap_start = len;
+    line->gap_end = LINE_CAPACITY;
+}
+
+/* Commande n-ieme plus recente (1 = la derniere) */
+static const char* history_entry(const LineEditor* line, uint32_t n) {
+    return line->history[(line->history_count - n) % LINE_HISTORY];
+}
+
+void line_history_push(LineEditor* line, const char* text) {
+    if (text[0] == '\0') return;
+    if (line->history_count > 0 && strcmp(history_entry(line, 1), text) == 0) return;
+
+    char* entry = line->history[line->history_count % LINE_HISTORY];
+    size_t len = strlen(text);
+    if (len > LINE_CAPACITY) len = LINE_CAPACITY;
+    memcpy(entry, text, len);
+    entry[len] = '\0';
+    line->history_count++;
+}
+
+int line_history_prev(LineEditor* line) {
+    uint32_t available = (line->history_count < LINE_HISTORY) ? line->history_count : LINE_HISTORY;
+    if (line->browse >= available) return 0;
+
+    /* On quitte le brouillon : il est mis de cote pour Down */
+    if (line->browse == 0) line_get(line, line->draft);
+    line->browse++;
+    line_set(line, history_entry(line, line->browse));
+    return 1;
+}
+
+int line_history_next(LineEditor* line) {
+    if (line->browse == 0) return 0;
+    line->browse--;
+    line_set(line, line->browse ? history_entry(line, line->browse) : line->draft);
+    return 1;
+}
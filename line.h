@@ -0,0 +1,67 @@
+#ifndef LINE_H
+#define LINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Discipline de ligne : la saisie en cours est editee dans un gap buffer, pas dans les cellules de l'historique.
+   Le terminal ne fait que redessiner la partie modifiee (voir input_render dans terminal.c) */
+
+#define LINE_INPUT_MAX 256 // taille d'une ligne de commande, terminateur compris
+#define LINE_HISTORY 16    // commandes gardees pour Up/Down
+
+/* Gap buffer : les caracteres avant le curseur sont dans text[0, gap_start), ceux apres dans text[gap_end, ...).
+   Inserer ou effacer au curseur ne deplace rien, deplacer le curseur d'une case deplace un caractere */
+typedef struct {
+    char text[LINE_INPUT_MAX - 1];
+    size_t gap_start;   // = position du curseur
+    size_t gap_end;
+
+    /* Historique des commandes : ring de LINE_HISTORY lignes */
+    char history[LINE_HISTORY][LINE_INPUT_MAX];
+    uint32_t history_count; // commandes ajoutees depuis le debut (la plus recente est history_count - 1)
+    uint32_t browse;        // 0 : on edite le brouillon, n : la n-ieme commande la plus recente est affichee
+    char draft[LINE_INPUT_MAX]; // brouillon mis de cote pendant qu'on parcourt l'historique
+} LineEditor;
+
+/* Ligne et historique des commandes vides */
+void line_init(LineEditor* line);
+
+/* Vide la ligne (l'historique des commandes est garde) */
+void line_reset(LineEditor* line);
+
+static inline size_t line_length(const LineEditor* line) {
+    return line->gap_start + (sizeof(line->text) - line->gap_end);
+}
+
+static inline size_t line_cursor(const LineEditor* line) {
+    return line->gap_start;
+}
+
+/* Caractere index de la ligne (index < line_length) */
+static inline char line_char(const LineEditor* line, size_t index) {
+    return (index < line->gap_start) ? line->text[index] : line->text[index + (line->gap_end - line->gap_start)];
+}
+
+/* Edition au curseur. Retournent 0 si rien n'a change (ligne pleine, curseur au debut / a la fin) */
+int line_insert(LineEditor* line, char c);
+int line_backspace(LineEditor* line);
+int line_delete(LineEditor* line);
+int line_left(LineEditor* line);
+int line_right(LineEditor* line);
+
+/* Place le curseur en position pos (bornee a la longueur) */
+void line_move(LineEditor* line, size_t pos);
+
+/* Recopie la ligne dans out (LINE_INPUT_MAX octets), terminee par '\0' */
+void line_get(const LineEditor* line, char* out);
+
+/* Ajoute une commande validee a l'historique (sauf si elle est vide ou identique a la precedente) */
+void line_history_push(LineEditor* line, const char* text);
+
+/* Up / Down : remplace la ligne par la commande precedente / suivante (le brouillon apres la plus recente).
+   Retournent 0 s'il n'y a rien dans cette direction */
+int line_history_prev(LineEditor* line);
+int line_history_next(LineEditor* line);
+
+#endif
@@ -0,0 +1,126 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "idt.h"
+#include "log.h"
+#include "string.h"
+#include "timer.h"
+
+/* --- Ring de log --- */
+/* Les records sont ranges a la suite dans un tableau circulaire d'octets. Les positions (head, tail, curseurs)
+   sont des offsets qui croissent sans fin, l'index dans le tableau est pos & (LOG_BUFFER_SIZE - 1).
+   - head : fin du dernier record publie
+   - tail : debut du plus ancien record encore valide, avance quand un nouveau record ecrase les plus vieux
+   Un record ne coupe jamais la fin du tableau : s'il ne tient pas, un record de bourrage remplit la fin.
+   Les producteurs (printk, y compris depuis une IRQ) sont serialises en coupant les interruptions le temps de la copie
+   (monoprocesseur). Les lecteurs ne prennent rien : ils revalident tail apres la copie et sautent ce qui a ete ecrase. */
+#define LOG_BUFFER_SIZE 65536
+#define LOG_ALIGN 16
+#define LOG_PADDING 0x01
+
+static uint8_t log_buffer[LOG_BUFFER_SIZE] __attribute__((aligned(LOG_ALIGN)));
+static uint32_t log_head;
+static uint32_t log_tail;
+
+LogStats log_stats;
+
+static inline LogRecord* record_at(uint32_t pos) {
+    return (LogRecord*) &log_buffer[pos & (LOG_BUFFER_SIZE - 1)];
+}
+
+/* Place occupee par un record dans le ring (en-tete + texte arrondi a LOG_ALIGN) */
+static inline uint32_t record_size(uint32_t len) {
+    return sizeof(LogRecord) + ((len + LOG_ALIGN - 1) & ~(uint32_t) (LOG_ALIGN - 1));
+}
+
+/* Un record de bourrage s'etend jusqu'a la fin du tableau */
+static inline uint32_t stored_size(uint32_t pos) {
+    LogRecord* record = record_at(pos);
+    if (record->flags & LOG_PADDING) return LOG_BUFFER_SIZE - (pos & (LOG_BUFFER_SIZE - 1));
+    return record_size(record->len);
+}
+
+/* Libere les plus anciens records jusqu'a ce que [.., end) tienne dans le ring. Interruptions coupees */
+static void log_make_room(uint32_t end) {
+    uint32_t tail = log_tail;
+
+    while (end - tail > LOG_BUFFER_SIZE) {
+        if (!(record_at(tail)->flags & LOG_PADDING)) log_stats.overwritten++;
+        tail += stored_size(tail);
+    }
+    /* Publie le nouveau tail avant d'ecraser : un lecteur qui revalide apres sa copie verra l'ecrasement */
+    __atomic_store_n(&log_tail, tail, __ATOMIC_RELEASE);
+}
+
+void log_append(int level, const char* text, size_t len) {
+    if (len > LOG_TEXT_MAX) {
+        len = LOG_TEXT_MAX;
+        log_stats.truncated++;
+    }
+
+    uint64_t timestamp = uptime_ns();
+    uint32_t size = record_size(len);
+    uint32_t flags = irq_save();
+    uint32_t pos = log_head;
+    uint32_t room_to_end = LOG_BUFFER_SIZE - (pos & (LOG_BUFFER_SIZE - 1));
+
+    if (size > room_to_end) {
+        log_make_room(pos + room_to_end);
+        record_at(pos)->flags = LOG_PADDING;
+        pos += room_to_end;
+    }
+    log_make_room(pos + size);
+
+    LogRecord* record = record_at(pos);
+    record->timestamp_ns = timestamp;
+    record->seq = log_stats.records++;
+    record->len = (uint16_t) len;
+    record->level = (uint8_t) level;
+    record->flags = 0;
+    memcpy(record + 1, text, len);
+
+    /* Publie le record : un lecteur ne voit le nouveau head qu'une fois le texte ecrit */
+    __atomic_store_n(&log_head, pos + size, __ATOMIC_RELEASE);
+    irq_restore(flags);
+}
+
+void log_cursor_init(LogCursor* cursor) {
+    cursor->pos = __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE);
+    cursor->lost = 0;
+}
+
+int log_pending(const LogCursor* cursor) {
+    return __atomic_load_n(&log_head, __ATOMIC_ACQUIRE) != cursor->pos;
+}
+
+int log_read(LogCursor* cursor, LogRecord* record, char* text, size_t size) {
+    while (1) {
+        uint32_t head = __atomic_load_n(&log_head, __ATOMIC_ACQUIRE);
+        uint32_t tail = __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE);
+        uint32_t pos = cursor->pos;
+
+        if (pos == head) return 0;
+        /* Le curseur pointe sur une zone deja recyclee : on repart du plus ancien record valide */
+        if ((int32_t) (tail - pos) > 0) {
+            cursor->lost++;
+            cursor->pos = tail;
+            continue;
+        }
+
+        *record = *record_at(pos);
+        if (record->flags & LOG_PADDING) {
+            cursor->pos = pos + LOG_BUFFER_SIZE - (pos & (LOG_BUFFER_SIZE - 1));
+            continue;
+        }
+
+        size_t copy = (record->len < size) ? record->len : size - 1;
+        memcpy(text, record_at(pos) + 1, copy);
+        text[copy] = '\0';
+
+        /* Revalide : si un producteur a recycle ce record pendant la copie, elle est fausse, on recommence */
+        tail = __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE);
+        if ((int32_t) (tail - pos) > 0) continue;
+
+        cursor->pos = pos + record_size(record->len);
+        return 1;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Niveaux de log (meme numerotation que syslog / Linux) */
+#define LOG_EMERG   0
+#define LOG_ALERT   1
+#define LOG_CRIT    2
+#define LOG_ERR     3
+#define LOG_WARNING 4
+#define LOG_NOTICE  5
+#define LOG_INFO    6
+#define LOG_DEBUG   7
+
+#define LOG_DEFAULT_LEVEL LOG_INFO
+
+/* Taille max du texte d'un record (au dela il est tronque) */
+#define LOG_TEXT_MAX 1024
+
+/* En-tete d'un record, suivi du texte (aligne sur 16 octets dans le ring) */
+typedef struct {
+    uint64_t timestamp_ns; // uptime_ns() au moment du printk
+    uint32_t seq;          // numero du record depuis le boot
+    uint16_t len;          // longueur du texte
+    uint8_t level;         // LOG_EMERG .. LOG_DEBUG
+    uint8_t flags;         // usage interne (record de bourrage en fin de ring)
+} LogRecord;
+
+/* Position d'un lecteur dans le ring. Chaque lecteur (console, dmesg) a la sienne */
+typedef struct {
+    uint32_t pos;  // offset (croissant) du prochain record a lire
+    uint32_t lost; // records ecrases avant d'avoir ete lus
+} LogCursor;
+
+typedef struct {
+    uint32_t records;     // records ecrits depuis le boot (= seq du prochain)
+    uint32_t overwritten; // records les plus anciens ecrases pour faire de la place
+    uint32_t truncated;   // messages coupes a LOG_TEXT_MAX
+} LogStats;
+
+extern LogStats log_stats;
+
+/* Ajoute un record. Ne fait aucun rendu : les consoles le liront plus tard (console_flush) */
+void log_append(int level, const char* text, size_t len);
+
+/* Place le curseur sur le plus ancien record encore present */
+void log_cursor_init(LogCursor* cursor);
+
+/* Lit le record suivant : en-tete dans *record, texte dans text (termine par '\0', tronque a size - 1).
+   Retourne 0 s'il n'y a rien de nouveau. Ne bloque jamais les producteurs : un record ecrase pendant la copie est saute */
+int log_read(LogCursor* cursor, LogRecord* record, char* text, size_t size);
+
+/* Retourne 1 si le curseur a des records a lire */
+int log_pending(const LogCursor* cursor);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MATH64_H
+#define MATH64_H
+
+#include <stdint.h>
+
+/* Le kernel est lie sans libgcc : une division 64-bit en C genererait un appel a __udivdi3 qui n'existe pas.
+   Ces helpers font les operations 64-bit dont on a besoin avec des instructions 32-bit. */
+
+/* Divise n (64-bit) par d (32-bit) avec deux divl, retourne le quotient et met le reste dans *rem si non NULL */
+static inline uint64_t udiv64_32(uint64_t n, uint32_t d, uint32_t* rem)
+{
+    uint32_t hi = (uint32_t) (n >> 32);
+    uint32_t lo = (uint32_t) n;
+    uint32_t q_hi = hi / d;
+    uint32_t q_lo, r;
+
+    hi %= d;
+    /* EDX:EAX / d, EDX (hi) < d donc le quotient tient sur 32 bits */
+    __asm__ ( "divl %4" : "=a"(q_lo), "=d"(r) : "a"(lo), "d"(hi), "rm"(d) );
+    if (rem) *rem = r;
+    return ((uint64_t) q_hi << 32) | q_lo;
+}
+
+/* (a * mult) >> 32 sans produit 128-bit : 4 produits 32x32 -> 64 */
+static inline uint64_t mul_u64_shr32(uint64_t a, uint64_t mult)
+{
+    uint32_t a_lo = (uint32_t) a, a_hi = (uint32_t) (a >> 32);
+    uint32_t m_lo = (uint32_t) mult, m_hi = (uint32_t) (mult >> 32);
+
+    uint64_t lo_lo = (uint64_t) a_lo * m_lo;
+    uint64_t lo_hi = (uint64_t) a_lo * m_hi;
+    uint64_t hi_lo = (uint64_t) a_hi * m_lo;
+    uint64_t hi_hi = (uint64_t) a_hi * m_hi;
+
+    return (lo_lo >> 32) + lo_hi + hi_lo + (hi_hi << 32);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+#include <stdint.h>
+
+/* Structures passees par GRUB selon la spec Multiboot 1 (EAX = magic, EBX = adresse de MultibootInfo) */
+
+/* Valeur de EAX quand le kernel a ete charge par un bootloader Multiboot */
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+
+/* Bits de MultibootInfo.flags : indiquent quels champs sont valides */
+#define MULTIBOOT_INFO_MEMORY  (1u << 0) // mem_lower / mem_upper
+#define MULTIBOOT_INFO_CMDLINE (1u << 2) // cmdline
+#define MULTIBOOT_INFO_MEM_MAP (1u << 6) // mmap_length / mmap_addr
+#define MULTIBOOT_INFO_FRAMEBUFFER (1u << 12) // framebuffer_*
+
+/* Types d'une zone de la memory map */
+#define MULTIBOOT_MEMORY_AVAILABLE 1
+#define MULTIBOOT_MEMORY_RESERVED  2
+#define MULTIBOOT_MEMORY_ACPI      3
+#define MULTIBOOT_MEMORY_NVS       4
+#define MULTIBOOT_MEMORY_BADRAM    5
+
+/* Types de framebuffer_type */
+#define MULTIBOOT_FRAMEBUFFER_TYPE_INDEXED  0 // palette
+#define MULTIBOOT_FRAMEBUFFER_TYPE_RGB      1 // composantes decrites par framebuffer_*_position / _mask_size
+#define MULTIBOOT_FRAMEBUFFER_TYPE_EGA_TEXT 2 // mode texte (pitch en octets, largeur et hauteur en caracteres)
+
+typedef struct {
+    uint32_t flags;
+    uint32_t mem_lower;   // KB de memoire basse (sous 1 MB)
+    uint32_t mem_upper;   // KB de memoire contigue a partir de 1 MB
+    uint32_t boot_device;
+    uint32_t cmdline;     // adresse physique de la ligne de commande (chaine C)
+    uint32_t mods_count;
+    uint32_t mods_addr;
+    uint32_t syms[4];
+    uint32_t mmap_length; // taille en octets de la memory map
+    uint32_t mmap_addr;   // adresse physique de la premiere entree
+    uint32_t drives_length;
+    uint32_t drives_addr;
+    uint32_t config_table;
+    uint32_t boot_loader_name;
+    uint32_t apm_table;
+    uint32_t vbe_control_info;
+    uint32_t vbe_mode_info;
+    uint16_t vbe_mode;
+    uint16_t vbe_interface_seg;
+    uint16_t vbe_interface_off;
+    uint16_t vbe_interface_len;
+    uint64_t framebuffer_addr;   // adresse physique du premier pixel
+    uint32_t framebuffer_pitch;  // octets entre deux lignes de pixels
+    uint32_t framebuffer_width;  // en pixels
+    uint32_t framebuffer_height;
+    uint8_t framebuffer_bpp;     // bits par pixel
+    uint8_t framebuffer_type;    // MULTIBOOT_FRAMEBUFFER_TYPE_*
+    uint8_t framebuffer_red_position; // type RGB : bit de poids faible et largeur de chaque composante
+    uint8_t framebuffer_red_mask_size;
+    uint8_t framebuffer_green_position;
+    uint8_t framebuffer_green_mask_size;
+    uint8_t framebuffer_blue_position;
+    uint8_t framebuffer_blue_mask_size;
+} __attribute__((packed)) MultibootInfo;
+
+/* Entree de la memory map. size ne compte pas le champ size lui-meme : l'entree suivante est a + size + 4 */
+typedef struct {
+    uint32_t size;
+    uint64_t addr;
+    uint64_t len;
+    uint32_t type;
+} __attribute__((packed)) MultibootMmapEntry;
+
+#endif
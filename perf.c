@@ -0,0 +1,159 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "io.h"
+#include "math64.h"
+#include "multiboot.h"
+#include "perf.h"
+#include "printk.h"
+#include "ps2.h"
+#include "serial.h"
+#include "timer.h"
+
+/* isa-debug-exit de QEMU (-device isa-debug-exit,iobase=0xf4,iosize=0x04) */
+static const uint16_t DEBUG_EXIT_PORT = 0xF4;
+
+/* Taille des phases : assez pour que le cout fixe (premier rendu, caches) soit negligeable, assez peu pour que
+   l'ensemble tienne en quelques secondes sous QEMU sans KVM */
+#define PERF_TEXT_LINES 4000
+#define PERF_TEXT_BATCH 32      // printk entre deux console_flush(), comme un message par tour de boucle charge
+#define PERF_SCROLL_ROUNDS 50   // aller-retours de PERF_SCROLL_PAGES pages
+#define PERF_SCROLL_PAGES 40
+#define PERF_STORM_ROUNDS 50    // lignes tapees puis effacees
+#define PERF_STORM_KEYS 70      // une ligne et demie : l'effacement traverse un retour a la ligne
+#define PERF_SWITCH_ROUNDS 100  // tours de F1 a F12
+#define PERF_SEARCH_ROUNDS 100
+
+/* Scancodes set 1 (make codes) */
+#define SC_ESCAPE 0x01
+#define SC_BACKSPACE 0x0E
+#define SC_Q 0x10
+#define SC_LCTRL 0x1D
+#define SC_A 0x1E
+#define SC_F 0x21
+#define SC_Z 0x2C
+#define SC_PAGE_UP 0x49
+#define SC_PAGE_DOWN 0x51
+#define PERF_CTRL 0x100 // la touche est tapee avec Ctrl enfonce
+
+static const uint8_t function_keys[12] = { 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40, 0x41, 0x42, 0x43, 0x44, 0x57, 0x58 };
+
+static void (*perf_drain)(void);
+
+/* Une frappe (appui et relachement, Ctrl autour si demande) puis un rendu : le cout interactif d'une touche */
+static void replay_key(uint16_t key) {
+    uint8_t code = (uint8_t) key;
+    if (key & PERF_CTRL) ps2_inject(SC_LCTRL);
+    ps2_inject(code);
+    ps2_inject((uint8_t) (code | 0x80));
+    if (key & PERF_CTRL) ps2_inject(SC_LCTRL | 0x80);
+    perf_drain();
+}
+
+/* --- Phases : chacune retourne le nombre d'unites traitees --- */
+/* Sortie du kernel : printk ajoute au log, console_flush() le rend par lots */
+static uint32_t phase_text(void) {
+    for (uint32_t i = 0; i < PERF_TEXT_LINES; i++) {
+        printk("perf line %u: the quick brown fox jumps over the lazy dog, 0x%x\n", i, i * 2654435761u);
+        if (i % PERF_TEXT_BATCH == PERF_TEXT_BATCH - 1) console_flush();
+    }
+    console_flush();
+    return PERF_TEXT_LINES;
+}
+
+/* Page Up / Page Down dans l'historique rempli par phase_text */
+static uint32_t phase_scroll(void) {
+    for (uint32_t round = 0; round < PERF_SCROLL_ROUNDS; round++) {
+        for (uint32_t i = 0; i < PERF_SCROLL_PAGES; i++) replay_key(SC_PAGE_UP);
+        for (uint32_t i = 0; i < PERF_SCROLL_PAGES; i++) replay_key(SC_PAGE_DOWN);
+    }
+    return PERF_SCROLL_ROUNDS * PERF_SCROLL_PAGES * 2;
+}
+
+static uint32_t phase_backspace(void) {
+    for (uint32_t round = 0; round < PERF_STORM_ROUNDS; round++) {
+        for (uint32_t i = 0; i < PERF_STORM_KEYS; i++) replay_key(SC_A);
+        for (uint32_t i = 0; i < PERF_STORM_KEYS; i++) replay_key(SC_BACKSPACE);
+    }
+    return PERF_STORM_ROUNDS * PERF_STORM_KEYS * 2;
+}
+
+/* Le premier tour alloue les ecrans, les suivants ne font que changer de slot VRAM (3 slots pour 12 ecrans) */
+static uint32_t phase_switch(void) {
+    for (uint32_t round = 0; round < PERF_SWITCH_ROUNDS; round++) {
+        for (uint32_t i = 0; i < 12; i++) replay_key(function_keys[i]);
+    }
+    replay_key(function_keys[0]);
+    return PERF_SWITCH_ROUNDS * 12 + 1;
+}
+
+/* Motif absent : chaque touche parcourt tout l'historique de F1, lignes froides comprises */
+static uint32_t phase_search(void) {
+    for (uint32_t round = 0; round < PERF_SEARCH_ROUNDS; round++) {
+        replay_key(PERF_CTRL | SC_F);
+        replay_key(SC_Z);
+        replay_key(SC_Q);
+        replay_key(SC_ESCAPE);
+    }
+    return PERF_SEARCH_ROUNDS * 4;
+}
+
+typedef struct {
+    const char* name;
+    const char* unit;
+    uint32_t (*run)(void);
+} PerfPhase;
+
+static const PerfPhase phases[] = {
+    { "text", "line", phase_text },
+    { "scroll", "key", phase_scroll },
+    { "backspace", "key", phase_backspace },
+    { "switch", "key", phase_switch },
+    { "search", "key", phase_search },
+};
+#define PERF_PHASE_COUNT (sizeof(phases) / sizeof(phases[0]))
+
+int perf_requested(const MultibootInfo* info) {
+    if (!(info->flags & MULTIBOOT_INFO_CMDLINE) || !info->cmdline) return 0;
+
+    /* QEMU passe "<chemin du kernel> <-append>" : on cherche le mot entier */
+    const char* word = (const char*) info->cmdline;
+    while (*word) {
+        while (*word == ' ') word++;
+        const char* end = word;
+        while (*end && *end != ' ') end++;
+        if (end - word == 4 && word[0] == 'p' && word[1] == 'e' && word[2] == 'r' && word[3] == 'f') return 1;
+        word = end;
+    }
+    return 0;
+}
+
+void perf_run(void (*drain)(void)) {
+    uint64_t cycles[PERF_PHASE_COUNT];
+    uint32_t units[PERF_PHASE_COUNT];
+    int sinks = console_sinks;
+
+    /* Pendant les mesures seule la VGA recoit la sortie : le debit de la ligne serie ne compte pas */
+    perf_drain = drain;
+    console_flush();
+    console_sinks = CONSOLE_VGA;
+    for (size_t i = 0; i < PERF_PHASE_COUNT; i++) {
+        uint64_t start = timer_cycles();
+        units[i] = phases[i].run();
+        cycles[i] = timer_cycles() - start;
+    }
+
+    console_sinks = CONSOLE_VGA | CONSOLE_SERIAL;
+    printk("perf: %u phases, TSC %u kHz\n", (uint32_t) PERF_PHASE_COUNT, tsc_khz);
+    for (size_t i = 0; i < PERF_PHASE_COUNT; i++) {
+        printk("perf %s %u %u cycles/%s\n", phases[i].name, units[i], (uint32_t) udiv64_32(cycles[i], units[i], NULL),
+               phases[i].unit);
+    }
+    console_flush();
+    serial_drain();
+    console_sinks = sinks;
+}
+
+void perf_exit(uint8_t status) {
+    outb(DEBUG_EXIT_PORT, status);
+    printk(KERN_WARNING "perf: no isa-debug-exit device, still running\n");
+}
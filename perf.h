@@ -0,0 +1,22 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+#include "multiboot.h"
+
+/* Charge de travail de reference rejouee au boot pour make perf (voir tests/perf.sh) :
+   texte, scroll, rafales de backspace, changements d'ecran et recherche, chaque phase chronometree au TSC.
+   Les touches passent par le ring de scancodes (ps2_inject) et le vrai consommateur, comme une frappe */
+
+/* 1 si la ligne de commande Multiboot contient le mot "perf" (qemu -kernel kfs.bin -append perf) */
+int perf_requested(const MultibootInfo* info);
+
+/* Rejoue toutes les phases puis ecrit une ligne "perf <phase> <unites> <cycles> cycles/<unite>" par phase sur la
+   console serie. drain consomme le ring de scancodes et fait le rendu (keyboard_handler de kernel.c) */
+void perf_run(void (*drain)(void));
+
+/* Arrete QEMU par isa-debug-exit (port 0xF4) : le code de sortie du process est (status << 1) | 1.
+   Sans ce peripherique l'ecriture est ignoree et le kernel continue */
+void perf_exit(uint8_t status);
+
+#endif
@@ -0,0 +1,222 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "multiboot.h"
+#include "pmm.h"
+#include "string.h"
+
+/* Bornes de l'image du kernel (linker.ld) */
+extern uint8_t kernel_start[];
+extern uint8_t kernel_end[];
+
+/* --- Constantes --- */
+static const uint64_t ADDRESS_LIMIT = 0x100000000ull; // pas de PAE : seuls les 4 premiers GB sont adressables
+static const uint32_t LOW_MEMORY_END = 0x100000;      // premier MB : IVT, BDA, VRAM, BIOS... jamais alloue
+
+/* --- Bitmap des pages physiques --- */
+/* 1 bit par page de 4 KB, 1 = occupee (reservee ou allouee). Tout ce que la memory map ne declare pas disponible
+   reste a 1. search_hint est le premier mot qui peut encore contenir une page libre : une allocation repart de la
+   et une liberation le fait reculer, un mot plein (0xFFFFFFFF) se saute en une comparaison -> O(1) amorti */
+static uint32_t* bitmap;
+static uint32_t bitmap_words;
+static uint32_t page_count;   // pages couvertes par le bitmap (jusqu'a la plus haute adresse utilisable)
+static uint32_t usable_pages; // pages declarees disponibles par la memory map
+static uint32_t free_pages;
+static uint32_t search_hint;
+
+PmmRegion pmm_regions[PMM_MAX_REGIONS];
+size_t pmm_region_count;
+
+static inline uint32_t align_up(uint32_t value) {
+    return (value + PAGE_SIZE - 1) & ~(uint32_t) (PAGE_SIZE - 1);
+}
+
+static inline int page_is_used(uint32_t page) {
+    return (bitmap[page / 32] >> (page % 32)) & 1;
+}
+
+static void mark_used(uint32_t first_page, uint32_t count) {
+    for (uint32_t page = first_page; page < first_page + count && page < page_count; page++) {
+        if (page_is_used(page)) continue;
+        bitmap[page / 32] |= 1u << (page % 32);
+        free_pages--;
+    }
+}
+
+static void mark_free(uint32_t first_page, uint32_t count) {
+    for (uint32_t page = first_page; page < first_page + count && page < page_count; page++) {
+        if (!page_is_used(page)) continue;
+        bitmap[page / 32] &= ~(1u << (page % 32));
+        free_pages++;
+        if (page / 32 < search_hint) search_hint = page / 32;
+    }
+}
+
+/* Reserve les pages qui touchent [start, end) */
+static void reserve_range(uint32_t start, uint32_t end) {
+    if (end <= start) return;
+    mark_used(start / PAGE_SIZE, (align_up(end) - (start & ~(uint32_t) (PAGE_SIZE - 1))) / PAGE_SIZE);
+}
+
+static void add_region(uint64_t base, uint64_t length, uint32_t type) {
+    if (pmm_region_count >= PMM_MAX_REGIONS || length == 0) return;
+    pmm_regions[pmm_region_count].base = base;
+    pmm_regions[pmm_region_count].length = length;
+    pmm_regions[pmm_region_count].type = type;
+    pmm_region_count++;
+}
+
+/* Recopie la memory map (les structures de GRUB peuvent ensuite etre ecrasees sans risque) */
+static void collect_regions(const MultibootInfo* info) {
+    pmm_region_count = 0;
+
+    if (info->flags & MULTIBOOT_INFO_MEM_MAP) {
+        uint32_t address = info->mmap_addr;
+        uint32_t end = info->mmap_addr + info->mmap_length;
+
+        while (address < end) {
+            const MultibootMmapEntry* entry = (const MultibootMmapEntry*) address;
+            add_region(entry->addr, entry->len, entry->type);
+            address += entry->size + sizeof(entry->size);
+        }
+    } else if (info->flags & MULTIBOOT_INFO_MEMORY) {
+        /* Pas de memory map : seulement la memoire basse et la zone contigue au dessus de 1 MB */
+        add_region(0, (uint64_t) info->mem_lower * 1024, MULTIBOOT_MEMORY_AVAILABLE);
+        add_region(LOW_MEMORY_END, (uint64_t) info->mem_upper * 1024, MULTIBOOT_MEMORY_AVAILABLE);
+    }
+}
+
+/* Cherche une zone disponible pour le bitmap, apres le kernel et sans recouvrir les structures Multiboot */
+static uint32_t place_bitmap(uint32_t size, uint32_t boot_start, uint32_t boot_end) {
+    for (size_t i = 0; i < pmm_region_count; i++) {
+        if (pmm_regions[i].type != MULTIBOOT_MEMORY_AVAILABLE || pmm_regions[i].base >= ADDRESS_LIMIT) continue;
+
+        uint64_t region_end = pmm_regions[i].base + pmm_regions[i].length;
+        if (region_end > ADDRESS_LIMIT) region_end = ADDRESS_LIMIT;
+
+        uint64_t start = pmm_regions[i].base;
+        if (start < (uint32_t) kernel_end) start = (uint32_t) kernel_end;
+        if (start < LOW_MEMORY_END) start = LOW_MEMORY_END;
+        start = align_up((uint32_t) start);
+        if (start < boot_end && start + size > boot_start) start = align_up(boot_end);
+
+        if (start + size <= region_end) return (uint32_t) start;
+    }
+    return 0;
+}
+
+uint32_t pmm_init(const MultibootInfo* info) {
+    uint64_t highest = 0;
+
+    collect_regions(info);
+    for (size_t i = 0; i < pmm_region_count; i++) {
+        if (pmm_regions[i].type != MULTIBOOT_MEMORY_AVAILABLE) continue;
+        uint64_t end = pmm_regions[i].base + pmm_regions[i].length;
+        if (end > ADDRESS_LIMIT) end = ADDRESS_LIMIT;
+        if (end > highest) highest = end;
+    }
+    if (highest == 0) return 0;
+
+    page_count = (uint32_t) (highest / PAGE_SIZE);
+    bitmap_words = (page_count + 31) / 32;
+
+    /* Structures Multiboot a proteger : l'info elle-meme et la memory map */
+    uint32_t boot_start = (uint32_t) info;
+    uint32_t boot_end = (uint32_t) info + sizeof(*info);
+    if (info->flags & MULTIBOOT_INFO_MEM_MAP) {
+        if (info->mmap_addr < boot_start) boot_start = info->mmap_addr;
+        if (info->mmap_addr + info->mmap_length > boot_end) boot_end = info->mmap_addr + info->mmap_length;
+    }
+
+    uint32_t bitmap_address = place_bitmap(bitmap_words * sizeof(uint32_t), boot_start, boot_end);
+    if (bitmap_address == 0) return 0;
+    bitmap = (uint32_t*) bitmap_address;
+
+    /* Tout est occupe, puis on libere les pages entierement contenues dans une zone disponible */
+    memset(bitmap, 0xFF, bitmap_words * sizeof(uint32_t));
+    free_pages = 0;
+    search_hint = bitmap_words;
+    for (size_t i = 0; i < pmm_region_count; i++) {
+        if (pmm_regions[i].type != MULTIBOOT_MEMORY_AVAILABLE || pmm_regions[i].base >= ADDRESS_LIMIT) continue;
+        uint64_t end = pmm_regions[i].base + pmm_regions[i].length;
+        if (end > ADDRESS_LIMIT) end = ADDRESS_LIMIT;
+        uint32_t first = align_up((uint32_t) pmm_regions[i].base) / PAGE_SIZE;
+        uint32_t last = (uint32_t) (end / PAGE_SIZE);
+        if (last > first) mark_free(first, last - first);
+    }
+    usable_pages = free_pages;
+
+    reserve_range(0, LOW_MEMORY_END);
+    reserve_range((uint32_t) kernel_start, (uint32_t) kernel_end);
+    reserve_range(boot_start, boot_end);
+    reserve_range(bitmap_address, bitmap_address + bitmap_words * sizeof(uint32_t));
+    return free_pages;
+}
+
+uint32_t pmm_alloc_page(void) {
+    for (uint32_t word = search_hint; word < bitmap_words; word++) {
+        if (bitmap[word] == 0xFFFFFFFF) continue;
+
+        uint32_t page = word * 32 + __builtin_ctz(~bitmap[word]);
+        if (page >= page_count) break;
+        bitmap[word] |= 1u << (page % 32);
+        free_pages--;
+        search_hint = word;
+        return page * PAGE_SIZE;
+    }
+    search_hint = bitmap_words;
+    return 0;
+}
+
+void pmm_free_page(uint32_t address) {
+    mark_free(address / PAGE_SIZE, 1);
+}
+
+uint32_t pmm_alloc_pages(size_t count) {
+    if (count == 0) return 0;
+    if (count == 1) return pmm_alloc_page();
+
+    uint32_t run_start = 0;
+    uint32_t run_length = 0;
+
+    /* Premier trou assez grand, en sautant les mots pleins */
+    for (uint32_t page = search_hint * 32; page < page_count; page++) {
+        if (page % 32 == 0 && bitmap[page / 32] == 0xFFFFFFFF) {
+            run_length = 0;
+            page += 31;
+            continue;
+        }
+        if (page_is_used(page)) {
+            run_length = 0;
+            continue;
+        }
+        if (run_length == 0) run_start = page;
+        if (++run_length == count) {
+            mark_used(run_start, count);
+            return run_start * PAGE_SIZE;
+        }
+    }
+    return 0;
+}
+
+void pmm_free_pages(uint32_t address, size_t count) {
+    mark_free(address / PAGE_SIZE, count);
+}
+
+void pmm_get_stats(PmmStats* stats) {
+    uint32_t run = 0;
+
+    stats->total_pages = usable_pages;
+    stats->free_pages = free_pages;
+    stats->used_pages = usable_pages - free_pages;
+    stats->free_runs = 0;
+    stats->largest_run = 0;
+
+    for (uint32_t page = 0; page < page_count; page++) {
+        if (page_is_used(page)) {
+            run = 0;
+            continue;
+        }
+        if (run++ == 0) stats->free_runs++;
+        if (run > stats->largest_run) stats->largest_run = run;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef PMM_H
+#define PMM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "multiboot.h"
+
+#define PAGE_SIZE 4096
+
+/* Zone de la memory map telle que vue au boot (pour la commande 'mem') */
+typedef struct {
+    uint64_t base;
+    uint64_t length;
+    uint32_t type; // MULTIBOOT_MEMORY_*
+} PmmRegion;
+
+#define PMM_MAX_REGIONS 32
+
+extern PmmRegion pmm_regions[PMM_MAX_REGIONS];
+extern size_t pmm_region_count;
+
+typedef struct {
+    uint32_t total_pages;  // pages de RAM utilisable (memory map)
+    uint32_t free_pages;
+    uint32_t used_pages;   // reservees (kernel, bitmap, premier MB) ou allouees
+    uint32_t free_runs;    // nombre de suites de pages libres contigues
+    uint32_t largest_run;  // plus longue suite de pages libres
+} PmmStats;
+
+/* Construit le bitmap des pages physiques a partir de la memory map Multiboot (ou de mem_upper a defaut),
+   puis reserve le premier MB, l'image du kernel, les structures Multiboot et le bitmap lui-meme.
+   Retourne le nombre de pages libres (0 si aucune information memoire n'est disponible) */
+uint32_t pmm_init(const MultibootInfo* info);
+
+/* Alloue une page physique (adresse alignee sur PAGE_SIZE), 0 si la memoire est epuisee */
+uint32_t pmm_alloc_page(void);
+void pmm_free_page(uint32_t address);
+
+/* Alloue count pages physiquement contigues (premier trou assez grand), 0 si aucun trou ne convient */
+uint32_t pmm_alloc_pages(size_t count);
+void pmm_free_pages(uint32_t address, size_t count);
+
+/* Compte les pages et les trous (parcours complet du bitmap, pour les statistiques seulement) */
+void pmm_get_stats(PmmStats* stats);
+
+#endif
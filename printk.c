@@ -0,0 +1,242 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "log.h"
+#include "math64.h"
+#include "printk.h"
+#include "serial.h"
+#include "smp.h"
+#include "terminal.h"
+#include "trace.h"
+
+/* Taille max d'un message printk (au dela il est tronque) */
+#define PRINTK_BUFFER_SIZE 1024
+
+int console_sinks = CONSOLE_VGA | CONSOLE_SERIAL;
+
+/* Position des consoles dans le ring de log */
+static LogCursor console_cursor;
+
+/* Curseur d'ecriture : on compte tout ce qui aurait du etre ecrit, on ne stocke que ce qui tient */
+typedef struct {
+    char* buf;
+    size_t size;
+    size_t len;
+} FormatOutput;
+
+static inline void out_char(FormatOutput* out, char c) {
+    if (out->len + 1 < out->size) out->buf[out->len] = c;
+    out->len++;
+}
+
+static void out_repeat(FormatOutput* out, char c, int count) {
+    while (count-- > 0) out_char(out, c);
+}
+
+/* Ecrit str (len caracteres) cadre dans width, a gauche si left, sinon a droite avec pad (' ' ou '0').
+   Avec '0' le signe / prefixe (prefix_len premiers caracteres de str) reste devant les zeros */
+static void out_field(FormatOutput* out, const char* str, int len, int width, int left, char pad, int prefix_len) {
+    int padding = (width > len) ? width - len : 0;
+
+    if (left) {
+        for (int i = 0; i < len; i++) out_char(out, str[i]);
+        out_repeat(out, ' ', padding);
+        return;
+    }
+    if (pad == '0') {
+        for (int i = 0; i < prefix_len; i++) out_char(out, str[i]);
+        out_repeat(out, '0', padding);
+        for (int i = prefix_len; i < len; i++) out_char(out, str[i]);
+        return;
+    }
+    out_repeat(out, ' ', padding);
+    for (int i = 0; i < len; i++) out_char(out, str[i]);
+}
+
+/* Convertit value en base 10 ou 16 a la fin de tmp (les chiffres sont produits a l'envers), retourne le debut */
+static char* format_unsigned(char* end, uint64_t value, uint32_t base, int upper) {
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char* p = end;
+
+    if (value == 0) *--p = '0';
+    while (value > 0) {
+        uint32_t digit;
+        /* Pas de libgcc : division 64-bit par un diviseur 32-bit avec udiv64_32 */
+        value = udiv64_32(value, base, &digit);
+        *--p = digits[digit];
+    }
+    return p;
+}
+
+int vsnprintk(char* buf, size_t size, const char* format, va_list args) {
+    FormatOutput out = { buf, size, 0 };
+
+	for (const char* p = format; *p != '\0'; p++) {
+		if (*p != '%') {
+			out_char(&out, *p);
+			continue;
+		}
+		p++; // Skip '%'
+
+        /* Drapeaux */
+        int left = 0;
+        char pad = ' ';
+        for (;; p++) {
+            if (*p == '-') left = 1;
+            else if (*p == '0') pad = '0';
+            else break;
+        }
+
+        /* Largeur */
+        int width = 0;
+        if (*p == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                left = 1;
+                width = -width;
+            }
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') width = width * 10 + (*p++ - '0');
+        }
+        if (left) pad = ' ';
+
+        /* Longueur : l = long (32-bit ici), ll = long long, z = size_t */
+        int longs = 0;
+        while (*p == 'l') {
+            longs++;
+            p++;
+        }
+        if (*p == 'z') p++;
+
+        /* '%' en fin de chaine : rien a convertir */
+        if (*p == '\0') break;
+
+        char tmp[24]; // 20 chiffres + signe pour 64-bit
+        char* end = tmp + sizeof(tmp);
+        char* start;
+
+		switch (*p) {
+			case 'c': {
+				char c = (char) va_arg(args, int);
+				out_field(&out, &c, 1, width, left, ' ', 0);
+				break;
+			}
+			case 's': {
+				const char* s = va_arg(args, const char*);
+				if (!s) s = "(null)";
+				int len = 0;
+				while (s[len]) len++;
+				out_field(&out, s, len, width, left, ' ', 0);
+				break;
+			}
+			case 'd':
+			case 'i': {
+				int64_t d = (longs >= 2) ? va_arg(args, long long) : (longs == 1) ? va_arg(args, long) : va_arg(args, int);
+				/* Valeur absolue en non signe : -INT_MIN deborde en signe mais pas en uint64_t */
+				uint64_t magnitude = (d < 0) ? (uint64_t) 0 - (uint64_t) d : (uint64_t) d;
+				start = format_unsigned(end, magnitude, 10, 0);
+				if (d < 0) *--start = '-';
+				out_field(&out, start, end - start, width, left, pad, d < 0);
+				break;
+			}
+			case 'u':
+			case 'x':
+			case 'X': {
+				uint64_t u = (longs >= 2) ? va_arg(args, unsigned long long) : (longs == 1) ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+				start = format_unsigned(end, u, (*p == 'u') ? 10 : 16, *p == 'X');
+				out_field(&out, start, end - start, width, left, pad, 0);
+				break;
+			}
+			case 'p': {
+				/* Adresse : 0x + 8 chiffres hexa */
+				uintptr_t ptr = (uintptr_t) va_arg(args, void*);
+				start = format_unsigned(end, ptr, 16, 0);
+				while (end - start < 8) *--start = '0';
+				*--start = 'x';
+				*--start = '0';
+				out_field(&out, start, end - start, width, left, ' ', 0);
+				break;
+			}
+			case '%':
+				out_char(&out, '%');
+				break;
+			default:
+				/* Conversion inconnue : ignoree (comme l'ancien printk) */
+				break;
+		}
+	}
+
+    if (size > 0) buf[(out.len < size) ? out.len : size - 1] = '\0';
+    return (int) out.len;
+}
+
+int snprintk(char* buf, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintk(buf, size, format, args);
+    va_end(args);
+    return len;
+}
+
+/* --- Printk --- */
+/* Formate dans buf et separe le prefixe de niveau optionnel "<n>". Retourne la longueur du texte pointe par *text */
+static int printk_format(char* buf, const char* format, va_list args, int* level, const char** text) {
+    int len = vsnprintk(buf, PRINTK_BUFFER_SIZE, format, args);
+    if (len > PRINTK_BUFFER_SIZE - 1) len = PRINTK_BUFFER_SIZE - 1;
+
+    *text = buf;
+    *level = LOG_DEFAULT_LEVEL;
+    if (len >= 3 && buf[0] == '<' && buf[1] >= '0' && buf[1] <= '7' && buf[2] == '>') {
+        *level = buf[1] - '0';
+        *text += 3;
+        len -= 3;
+    }
+    return len;
+}
+
+void printk(const char* format, ...) {
+    char buf[PRINTK_BUFFER_SIZE];
+    const char* text;
+    int level, len;
+	va_list args;
+
+    /* Sur un AP : ni log ni traces (ils n'appartiennent qu'au BSP), le message part dans la file du CPU (smp.c) */
+    uint32_t cpu = smp_cpu_index();
+    if (cpu != 0) {
+        va_start(args, format);
+        len = printk_format(buf, format, args, &level, &text);
+        va_end(args);
+        smp_queue_push(cpu, level, text, len);
+        return;
+    }
+
+    TRACE_SCOPE(TRACE_PRINTK);
+	va_start(args, format);
+    len = printk_format(buf, format, args, &level, &text);
+	va_end(args);
+    log_append(level, text, len);
+}
+
+void console_flush(void) {
+    LogRecord record;
+    char text[LOG_TEXT_MAX + 1];
+    int rendered = 0;
+
+    /* Le BSP est le seul proprietaire de la console : les messages des APs passent d'abord dans le log */
+    smp_drain();
+    while (log_read(&console_cursor, &record, text, sizeof(text))) {
+        /* Cote VGA on ecrit sans rendre, cote serie on copie seulement dans le ring d'emission (vide par l'IRQ4) */
+        if (console_sinks & CONSOLE_VGA) {
+            terminal_append(text, record.len);
+            rendered = 1;
+        }
+        if (console_sinks & CONSOLE_SERIAL) serial_write(text, record.len);
+    }
+    /* Un seul rendu et une seule mise a jour du curseur pour tout le lot */
+    if (rendered) refresh_screen();
+}
+
+int console_pending(void) {
+    return log_pending(&console_cursor) || smp_pending();
+}
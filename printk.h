@@ -0,0 +1,38 @@
+#ifndef PRINTK_H
+#define PRINTK_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/* Formate dans buf (size octets, toujours termine par '\0' si size > 0) et retourne la longueur complete du resultat,
+   meme si elle depasse size (comme vsnprintf).
+   Conversions : %c %s %d %i %u %x %X %p %%, longueurs l / ll / z, drapeaux '-' et '0', largeur (nombre ou '*') */
+int vsnprintk(char* buf, size_t size, const char* format, va_list args);
+int snprintk(char* buf, size_t size, const char* format, ...);
+
+/* Prefixes de niveau (a mettre en tete du format : printk(KERN_ERR "...")), sans prefixe : LOG_DEFAULT_LEVEL */
+#define KERN_EMERG   "<0>"
+#define KERN_ALERT   "<1>"
+#define KERN_CRIT    "<2>"
+#define KERN_ERR     "<3>"
+#define KERN_WARNING "<4>"
+#define KERN_NOTICE  "<5>"
+#define KERN_INFO    "<6>"
+#define KERN_DEBUG   "<7>"
+
+/* Destinations des consoles (masque de bits), modifiable a chaud par la commande 'console' */
+#define CONSOLE_VGA    0x1
+#define CONSOLE_SERIAL 0x2
+
+extern int console_sinks;
+
+/* Formate le message et l'ajoute au ring de log (log.c). Aucun rendu ici : les consoles le recoivent au prochain console_flush() */
+void printk(const char* format, ...);
+
+/* Draine le ring de log vers les consoles actives (un seul rendu VGA pour tout le lot). Appele depuis la boucle principale */
+void console_flush(void);
+
+/* Retourne 1 si des messages attendent d'etre envoyes aux consoles */
+int console_pending(void);
+
+#endif
@@ -0,0 +1,215 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "io.h"
+#include "idt.h"
+#include "ps2.h"
+#include "timer.h"
+
+/* --- Port mapping --- */
+static const uint16_t STATUS_KEYBOARD_PORT = 0x64; // Port status : lire l'état si le bit de status est a 1 -> il y'a une entree clavier a lire sur le port 0x60
+static const uint16_t DATA_KEYBOARD_PORT = 0x60; // Port data : Permet de lire la touche clavier (Presse/relache)
+
+/* --- Commandes du clavier (ecrites sur le port data) --- */
+static const uint8_t KEYBOARD_SET_LEDS = 0xED;       // suivi de l'etat des LEDs (bit 0 Scroll, 1 Num, 2 Caps)
+static const uint8_t KEYBOARD_SET_TYPEMATIC = 0xF3;  // suivi du delai et de la cadence de repetition
+static const uint32_t WRITE_TIMEOUT = 100000;        // lectures du status avant d'abandonner une ecriture
+
+/* --- Reponses du clavier --- */
+static const uint8_t KEYBOARD_ACK = 0xFA;
+static const uint8_t KEYBOARD_RESEND = 0xFE;         // octet mal recu : le renvoyer
+static const uint32_t COMMAND_RETRIES = 3;           // renvois (0xFE ou delai depasse) avant d'abandonner la commande
+static const uint32_t COMMAND_TIMEOUT_TICKS = TIMER_HZ / 10; // sans reponse, l'octet est renvoye (ps2_poll)
+
+/* --- Ring de scancodes --- */
+/* Ring single-producer / single-consumer sans verrou :
+   - le producteur est l'IRQ1, il est le seul a ecrire ring_head
+   - le consommateur est la boucle principale, elle est la seule a ecrire ring_tail
+   Les index tournent librement (uint32), head - tail = nombre d'elements, la taille est une puissance de 2 */
+#define PS2_RING_SIZE 256
+
+static Ps2Scancode ring[PS2_RING_SIZE];
+static uint32_t ring_head; // prochain slot a ecrire (producteur)
+static uint32_t ring_tail; // prochain slot a lire (consommateur)
+
+Ps2Stats ps2_stats;
+
+/* Producteur : ajoute un scancode au ring (appele par l'IRQ1, ou par ps2_inject interruptions coupees) */
+static void ring_push(uint8_t scancode, uint64_t timestamp) {
+    uint32_t head = ring_head;
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= PS2_RING_SIZE) {
+        ps2_stats.dropped++;
+        return;
+    }
+
+    ring[head & (PS2_RING_SIZE - 1)] = (Ps2Scancode) { timestamp, scancode };
+    /* Publie le slot : le consommateur ne voit le nouvel head qu'une fois le scancode ecrit */
+    __atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+
+    ps2_stats.received++;
+    if (head + 1 - tail > ps2_stats.high_water) ps2_stats.high_water = head + 1 - tail;
+}
+
+/* Handler IRQ1 : vide tout le buffer du controleur (il faut lire chaque octet meme si le ring est plein pour le liberer).
+   Chaque octet est date au TSC a la capture : c'est l'origine de la latence mesuree par keyboard_handler() */
+static void ps2_irq(InterruptFrame* frame) {
+    (void) frame;
+    while (inb(STATUS_KEYBOARD_PORT) & 0x1) {
+        uint8_t scancode = inb(DATA_KEYBOARD_PORT);
+        ring_push(scancode, timer_cycles());
+    }
+}
+
+/* L'injection est un second producteur : interruptions coupees, l'IRQ1 ne peut pas publier le meme slot */
+void ps2_inject(uint8_t scancode) {
+    uint32_t flags = irq_save();
+    ring_push(scancode, timer_cycles());
+    irq_restore(flags);
+}
+
+static int ring_pop(Ps2Scancode* scancode) {
+    uint32_t tail = ring_tail;
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    if (head == tail) return 0;
+
+    *scancode = ring[tail & (PS2_RING_SIZE - 1)];
+    /* Libere le slot seulement apres l'avoir lu */
+    __atomic_store_n(&ring_tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int ps2_pending(void) {
+    return __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE) != ring_tail;
+}
+
+/* Attend que le buffer d'entree du controleur soit libre (bit 1 du status) puis ecrit l'octet pour le clavier */
+static void ps2_write(uint8_t byte) {
+    for (uint32_t i = 0; i < WRITE_TIMEOUT && (inb(STATUS_KEYBOARD_PORT) & 0x2); i++) { }
+    outb(DATA_KEYBOARD_PORT, byte);
+}
+
+/* --- Commandes a parametre --- */
+/* 0xED et 0xF3 se font en deux temps : l'octet de commande, puis le parametre seulement apres son ACK (0xFA).
+   Un 0xFE, ou aucune reponse apres COMMAND_TIMEOUT_TICKS (ps2_poll), fait renvoyer le dernier octet, au plus
+   COMMAND_RETRIES fois. Les reponses arrivent par l'IRQ1 dans le ring : c'est ps2_read() (la boucle principale) qui
+   les consomme et fait avancer la commande, jamais l'IRQ.
+   Une seule commande est en vol ; les demandes suivantes attendent dans leur slot et une nouvelle demande du meme
+   type remplace la valeur en attente (seul le dernier etat des LEDs compte) */
+typedef struct {
+    uint8_t command;  // KEYBOARD_SET_*
+    uint8_t data;     // parametre, lu au moment de l'envoi
+    uint8_t wanted;   // 1 si la commande attend d'etre envoyee
+} Ps2Command;
+
+static Ps2Command command_leds = { KEYBOARD_SET_LEDS, 0, 0 };
+static Ps2Command command_typematic = { KEYBOARD_SET_TYPEMATIC, 0, 0 };
+static Ps2Command* in_flight;          // commande en attente d'ACK (NULL : aucune)
+static uint8_t in_flight_data;         // 1 une fois le parametre envoye
+static uint32_t in_flight_retries;
+static uint32_t in_flight_ticks;       // timer_ticks au dernier octet envoye
+
+/* Envoie l'octet courant de la commande en vol : la commande, ou le parametre apres le premier ACK */
+static void command_write(void) {
+    ps2_write(in_flight_data ? in_flight->data : in_flight->command);
+    in_flight_ticks = timer_ticks;
+}
+
+/* Lance la prochaine commande en attente si aucune n'est en vol */
+static void command_start(void) {
+    if (in_flight) return;
+    Ps2Command* next = command_leds.wanted ? &command_leds : command_typematic.wanted ? &command_typematic : NULL;
+    if (!next) return;
+    next->wanted = 0;
+    in_flight = next;
+    in_flight_data = 0;
+    in_flight_retries = 0;
+    command_write();
+}
+
+/* Renvoie l'octet courant (0xFE ou delai depasse). Au-dela de COMMAND_RETRIES la commande est abandonnee */
+static void command_retry(void) {
+    if (++in_flight_retries <= COMMAND_RETRIES) {
+        command_write();
+        return;
+    }
+    ps2_stats.command_errors++;
+    in_flight = NULL;
+    command_start();
+}
+
+/* Consommateur : fait avancer la commande en vol. Retourne 1 si l'octet etait sa reponse (a ne pas decoder) */
+static int command_reply(uint8_t byte) {
+    if (!in_flight || (byte != KEYBOARD_ACK && byte != KEYBOARD_RESEND)) return 0;
+
+    if (byte == KEYBOARD_RESEND) {
+        command_retry();
+        return 1;
+    } else if (!in_flight_data) {
+        in_flight_data = 1;
+        command_write();
+        return 1;
+    } else {
+        in_flight = NULL;
+    }
+    command_start();
+    return 1;
+}
+
+/* Producteur de commandes (boucle principale) */
+static void command_request(Ps2Command* command, uint8_t data) {
+    command->data = data;
+    command->wanted = 1;
+    command_start();
+}
+
+/* Une reponse deja dans le ring n'est pas perdue : elle sera vue par ps2_read(), pas de renvoi tant qu'il en reste */
+void ps2_poll(void) {
+    if (in_flight && !ps2_pending() && timer_ticks - in_flight_ticks > COMMAND_TIMEOUT_TICKS) command_retry();
+}
+
+int ps2_read(Ps2Scancode* scancode) {
+    while (ring_pop(scancode)) {
+        if (!command_reply(scancode->scancode)) return 1;
+    }
+    return 0;
+}
+
+void ps2_set_leds(uint8_t leds) {
+    command_request(&command_leds, leds & 0x07);
+}
+
+void ps2_set_typematic(uint8_t delay, uint8_t rate) {
+    command_request(&command_typematic, (uint8_t) (((delay & 0x03) << 5) | (rate & 0x1F)));
+}
+
+/* --- Commandes avant l'IRQ1 --- */
+/* Envoie un octet et lit la reponse directement sur le port data (interruptions encore coupees).
+   Les scancodes tapes pendant le boot sont jetes ; 0xFE fait renvoyer l'octet. Retourne 1 sur ACK */
+static int ps2_write_polled(uint8_t byte) {
+    for (uint32_t attempt = 0; attempt <= COMMAND_RETRIES; attempt++) {
+        ps2_write(byte);
+        uint8_t reply = 0;
+        while (reply != KEYBOARD_ACK && reply != KEYBOARD_RESEND) {
+            uint32_t i = 0;
+            while (i < WRITE_TIMEOUT && !(inb(STATUS_KEYBOARD_PORT) & 0x1)) i++;
+            if (i == WRITE_TIMEOUT) return 0;
+            reply = inb(DATA_KEYBOARD_PORT);
+        }
+        if (reply == KEYBOARD_ACK) return 1;
+    }
+    return 0;
+}
+
+static void command_polled(uint8_t command, uint8_t data) {
+    if (!ps2_write_polled(command) || !ps2_write_polled(data)) ps2_stats.command_errors++;
+}
+
+void ps2_init(void) {
+    /* Clean le port de lecture clavier */
+    while (inb(STATUS_KEYBOARD_PORT) & 0x1) inb(DATA_KEYBOARD_PORT);
+    /* LEDs eteintes (le decodeur demarre sans Lock) et repetition explicite : 500 ms puis 10.9/s.
+       L'IRQ1 n'est pas encore branchee : chaque ACK est attendu sur le port avant l'octet suivant */
+    command_polled(KEYBOARD_SET_LEDS, 0);
+    command_polled(KEYBOARD_SET_TYPEMATIC, (uint8_t) ((1 << 5) | 0x0B));
+    irq_register(1, ps2_irq);
+}
@@ -0,0 +1,51 @@
+#ifndef PS2_H
+#define PS2_H
+
+#include <stdint.h>
+
+/* Statistiques du ring de scancodes */
+typedef struct {
+    uint32_t received;   // scancodes recus par l'IRQ1
+    uint32_t dropped;    // scancodes perdus car le ring etait plein
+    uint32_t high_water; // remplissage maximum observe du ring
+    uint32_t command_errors; // commandes LEDs / typematique abandonnees (sans ACK, ou 0xFE trop de fois)
+} Ps2Stats;
+
+extern Ps2Stats ps2_stats;
+
+/* Octet recu du clavier, date au TSC par l'IRQ1 */
+typedef struct {
+    uint64_t timestamp;  // timer_cycles() a la lecture du port (0 sans TSC)
+    uint8_t scancode;
+} Ps2Scancode;
+
+/* LEDs du clavier (ps2_set_leds) */
+#define PS2_LED_SCROLL 0x01
+#define PS2_LED_NUM    0x02
+#define PS2_LED_CAPS   0x04
+
+/* Vide le controleur et branche l'IRQ1 (les interruptions doivent ensuite etre activees par l'appelant) */
+void ps2_init(void);
+
+/* Consommateur : retire le plus ancien scancode du ring. Retourne 0 si le ring est vide.
+   Les reponses (0xFA, 0xFE) a une commande en cours sont consommees ici et font avancer la commande */
+int ps2_read(Ps2Scancode* scancode);
+
+/* Rejoue un scancode comme s'il venait du clavier (charge de travail de perf.c), date a l'injection */
+void ps2_inject(uint8_t scancode);
+
+/* Retourne 1 si au moins un scancode attend dans le ring */
+int ps2_pending(void);
+
+/* Allume les LEDs PS2_LED_*. Sans attente : le parametre part quand ps2_read() voit l'ACK de la commande */
+void ps2_set_leds(uint8_t leds);
+
+/* Repetition typematique : delai avant repetition (0..3 = 250..1000 ms) et cadence (0 = 30/s .. 31 = 2/s).
+   Meme envoi que ps2_set_leds() */
+void ps2_set_typematic(uint8_t delay, uint8_t rate);
+
+/* Commande sans reponse (ACK perdu, clavier debranche) : renvoie l'octet apres 100 ms, puis l'abandonne
+   (ps2_stats.command_errors) apres quelques renvois. A appeler regulierement par la boucle principale */
+void ps2_poll(void);
+
+#endif
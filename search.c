@@ -0,0 +1,88 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "history.h"
+#include "search.h"
+#include "string.h"
+
+void search_start(Search* search, size_t row, size_t column, size_t view_row) {
+    search->length = 0;
+    search->active = 1;
+    search->found = 0;
+    search->row = row;
+    search->column = column;
+    search->origin_view = view_row;
+}
+
+/* Derniere occurrence de la ligne (width cellules) avant la colonne limit (exclue), width si aucune */
+static size_t find_last(const Search* search, const uint16_t* cells, size_t width, size_t limit) {
+    size_t last = width;
+    size_t from = 0;
+
+    while (from < limit) {
+        size_t at = from + memfind16(cells + from, width - from, search->query, search->length);
+        if (at >= limit) break;
+        last = at;
+        from = at + 1;
+    }
+    return last;
+}
+
+int search_find(Search* search, History* history, SearchDirection direction, int inclusive) {
+    size_t rows = history_rows(history);
+    size_t width = history->width;
+    size_t row = search->row;
+
+    /* Un motif qui vient de changer et n'est plus trouve n'a plus d'occurrence courante */
+    if (inclusive) search->found = 0;
+    if (search->length == 0 || rows == 0) return 0;
+    if (row >= rows) row = rows - 1;
+
+    if (direction == SEARCH_OLDER) {
+        /* Premiere ligne : seulement avant la position courante */
+        size_t limit = search->column + (inclusive ? 1 : 0);
+        for (;;) {
+            const uint16_t* cells = history_peek(history, row);
+            if (cells) {
+                size_t column = find_last(search, cells, width, limit);
+                if (column < width) {
+                    search->row = row;
+                    search->column = column;
+                    search->found = 1;
+                    return 1;
+                }
+            }
+            if (row == 0) return 0;
+            row--;
+            limit = width;
+        }
+    }
+
+    size_t from = search->column + (inclusive ? 0 : 1);
+    for (; row < rows; row++, from = 0) {
+        const uint16_t* cells = history_peek(history, row);
+        if (!cells || from >= width) continue;
+        size_t column = from + memfind16(cells + from, width - from, search->query, search->length);
+        if (column < width) {
+            search->row = row;
+            search->column = column;
+            search->found = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void search_highlight(const Search* search, uint16_t* cells, size_t width, size_t row, uint8_t match,
+                      uint8_t current) {
+    size_t from = 0;
+
+    if (search->length == 0) return;
+    while (from < width) {
+        size_t at = from + memfind16(cells + from, width - from, search->query, search->length);
+        if (at >= width) return;
+
+        uint8_t color = (search->found && row == search->row && at == search->column) ? current : match;
+        for (size_t i = at; i < at + search->length; i++) cells[i] = (uint16_t) ((cells[i] & 0xFF) | (color << 8));
+        from = at + search->length;
+    }
+}
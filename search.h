@@ -0,0 +1,43 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "history.h"
+
+/* Recherche incrementale dans l'historique d'un ecran (Ctrl+F).
+   Le moteur ne fait que trouver les occurrences (memfind16 sur les cellules, lignes froides decodees au passage) :
+   la saisie du motif, le deplacement de la vue et la surbrillance sont faits par le terminal (voir terminal.c).
+   Une occurrence coupee par un retour a la ligne automatique n'est pas trouvee */
+
+#define SEARCH_QUERY_MAX 32
+
+typedef enum {
+    SEARCH_OLDER,  // vers le haut de l'historique
+    SEARCH_NEWER,  // vers le curseur
+} SearchDirection;
+
+typedef struct {
+    char query[SEARCH_QUERY_MAX];
+    uint8_t length;
+    uint8_t active;       // 1 : les touches vont a la recherche
+    uint8_t found;        // 1 : (row, column) est une occurrence de query
+    size_t row;           // occurrence courante (ou point de depart tant qu'on n'a rien trouve)
+    size_t column;
+    size_t origin_view;   // view_row a l'entree, remis par Echap
+} Search;
+
+/* Entre en recherche avec un motif vide, en partant de (row, column) */
+void search_start(Search* search, size_t row, size_t column, size_t view_row);
+
+/* Occurrence suivante dans la direction donnee. inclusive : la position courante compte (motif qui vient de changer).
+   Renvoie 1 et deplace (row, column) si elle existe, sinon 0 et la position ne bouge pas (found retombe a 0 si
+   inclusive : l'ancienne occurrence ne correspond plus au motif) */
+int search_find(Search* search, History* history, SearchDirection direction, int inclusive);
+
+/* Change l'attribut des occurrences dans une ligne deja rendue (cells, width cellules de la ligne row) :
+   current pour l'occurrence courante, match pour les autres */
+void search_highlight(const Search* search, uint16_t* cells, size_t width, size_t row, uint8_t match,
+                      uint8_t current);
+
+#endif
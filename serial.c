@@ -0,0 +1,157 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "idt.h"
+#include "io.h"
+#include "serial.h"
+
+/* --- Port mapping (COM1) --- */
+static const uint16_t COM1 = 0x3F8;
+#define SERIAL_DATA  (COM1 + 0) // THR en ecriture / RBR en lecture (DLL si DLAB = 1)
+#define SERIAL_IER   (COM1 + 1) // Interrupt Enable Register (DLM si DLAB = 1)
+#define SERIAL_IIR   (COM1 + 2) // Interrupt Identification en lecture / FIFO Control en ecriture
+#define SERIAL_LCR   (COM1 + 3) // Line Control (format, DLAB)
+#define SERIAL_MCR   (COM1 + 4) // Modem Control (DTR, RTS, OUT2, loopback)
+#define SERIAL_LSR   (COM1 + 5) // Line Status
+#define SERIAL_MSR   (COM1 + 6) // Modem Status
+
+/* --- Constantes --- */
+static const uint8_t LCR_8N1 = 0x03;
+static const uint8_t LCR_DLAB = 0x80;
+static const uint8_t FCR_ENABLE_CLEAR_14 = 0xC7;  // FIFO on, vide RX/TX, seuil RX a 14 octets
+static const uint8_t MCR_DTR_RTS_OUT2 = 0x0B;      // OUT2 relie la sortie d'interruption de l'UART au PIC
+static const uint8_t MCR_LOOPBACK = 0x1E;
+static const uint8_t IER_THRE = 0x02;              // interruption quand le registre d'emission est vide
+static const uint8_t LSR_THRE = 0x20;              // FIFO d'emission vide
+static const uint8_t LSR_TEMT = 0x40;              // FIFO et registre a decalage vides : tout est parti sur la ligne
+static const uint8_t TX_FIFO_SIZE = 16;            // FIFO d'emission du 16550A
+static const uint8_t SERIAL_IRQ = 4;
+
+/* --- Ring d'emission --- */
+/* Les producteurs (printk) et le consommateur (IRQ4 ou mode polle) sont sur le meme CPU : chaque acces se fait
+   interruptions coupees (irq_save), le temps de copier quelques octets, sans jamais attendre l'UART */
+#define SERIAL_RING_SIZE 4096
+
+static uint8_t ring[SERIAL_RING_SIZE];
+static uint32_t ring_head; // prochain octet a ecrire
+static uint32_t ring_tail; // prochain octet a envoyer
+
+static int serial_present = 0;
+static int serial_irq_enabled = 0;
+
+SerialStats serial_stats;
+
+static void ring_push(uint8_t byte) {
+    if (ring_head - ring_tail >= SERIAL_RING_SIZE) {
+        serial_stats.dropped++;
+        return;
+    }
+    ring[ring_head++ & (SERIAL_RING_SIZE - 1)] = byte;
+    if (ring_head - ring_tail > serial_stats.high_water) serial_stats.high_water = ring_head - ring_tail;
+}
+
+/* Une seule lecture du LSR : si la FIFO est vide on y pousse jusqu'a 16 octets, sinon on reviendra plus tard
+   (interruption THRE ou prochain appel). Interruptions coupees */
+static void fill_tx_fifo(void) {
+    if (!(inb(SERIAL_LSR) & LSR_THRE)) return;
+    for (uint8_t i = 0; i < TX_FIFO_SIZE && ring_tail != ring_head; i++) {
+        outb(SERIAL_DATA, ring[ring_tail++ & (SERIAL_RING_SIZE - 1)]);
+        serial_stats.bytes_sent++;
+    }
+}
+
+/* THRE n'est demande que s'il reste quelque chose a envoyer, sinon l'UART interromprait en boucle */
+static void update_tx_interrupt(void) {
+    if (!serial_irq_enabled) return;
+    outb(SERIAL_IER, (ring_tail != ring_head) ? IER_THRE : 0);
+}
+
+static void serial_irq(InterruptFrame* frame) {
+    (void) frame;
+    uint8_t iir;
+
+    /* Bit 0 de l'IIR a 0 : une interruption est en attente, bits 1-3 : sa cause */
+    while (!((iir = inb(SERIAL_IIR)) & 0x01)) {
+        switch (iir & 0x0E) {
+            case 0x02: // THR vide
+                serial_stats.tx_irqs++;
+                fill_tx_fifo();
+                break;
+            case 0x04: // donnees recues
+            case 0x0C: // timeout de la FIFO RX
+                inb(SERIAL_DATA);
+                break;
+            case 0x06: // erreur de ligne
+                inb(SERIAL_LSR);
+                break;
+            default:   // etat modem
+                inb(SERIAL_MSR);
+                break;
+        }
+    }
+    update_tx_interrupt();
+}
+
+void serial_set_divisor(uint16_t divisor) {
+    uint32_t flags = irq_save();
+    outb(SERIAL_LCR, LCR_DLAB);
+    outb(SERIAL_DATA, (uint8_t) (divisor & 0xFF));
+    outb(SERIAL_IER, (uint8_t) ((divisor >> 8) & 0xFF));
+    outb(SERIAL_LCR, LCR_8N1);
+    irq_restore(flags);
+}
+
+int serial_init(uint16_t divisor) {
+    outb(SERIAL_IER, 0x00);
+    serial_set_divisor(divisor);
+    outb(SERIAL_IIR, FCR_ENABLE_CLEAR_14);
+
+    /* Test en loopback : un octet envoye doit revenir, sinon il n'y a pas d'UART sur COM1 */
+    outb(SERIAL_MCR, MCR_LOOPBACK);
+    outb(SERIAL_DATA, 0xAE);
+    if (inb(SERIAL_DATA) != 0xAE) return 0;
+
+    outb(SERIAL_MCR, MCR_DTR_RTS_OUT2);
+    serial_present = 1;
+    return 1;
+}
+
+void serial_enable_irq(void) {
+    if (!serial_present) return;
+    irq_register(SERIAL_IRQ, serial_irq);
+    uint32_t flags = irq_save();
+    serial_irq_enabled = 1;
+    /* Si le ring a deja du contenu (messages de boot), THRE se declenche tout de suite et le vide */
+    update_tx_interrupt();
+    irq_restore(flags);
+}
+
+void serial_write(const char* data, size_t size) {
+    if (!serial_present) return;
+
+    uint32_t flags = irq_save();
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] == '\n') ring_push('\r');
+        ring_push((uint8_t) data[i]);
+    }
+    fill_tx_fifo();
+    update_tx_interrupt();
+    irq_restore(flags);
+}
+
+void serial_drain(void) {
+    if (!serial_present) return;
+
+    uint32_t flags = irq_save();
+    while (ring_tail != ring_head || !(inb(SERIAL_LSR) & LSR_TEMT)) fill_tx_fifo();
+    update_tx_interrupt();
+    irq_restore(flags);
+}
+
+void serial_poll(void) {
+    if (!serial_present) return;
+
+    uint32_t flags = irq_save();
+    fill_tx_fifo();
+    update_tx_interrupt();
+    irq_restore(flags);
+}
@@ -0,0 +1,40 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Diviseur de baud par defaut (115200 / diviseur), surchargeable a la compilation (make SERIAL_BAUD_DIVISOR=12 -> 9600) */
+#ifndef SERIAL_BAUD_DIVISOR
+#define SERIAL_BAUD_DIVISOR 1
+#endif
+
+/* Statistiques d'emission */
+typedef struct {
+    uint32_t bytes_sent;  // octets pousses dans la FIFO du 16550
+    uint32_t dropped;     // octets perdus car le ring d'emission etait plein
+    uint32_t high_water;  // remplissage maximum du ring d'emission
+    uint32_t tx_irqs;     // interruptions THRE traitees
+} SerialStats;
+
+extern SerialStats serial_stats;
+
+/* Initialise COM1 (8N1, FIFO activee). Retourne 0 si aucun UART ne repond (la sortie serie est alors ignoree) */
+int serial_init(uint16_t divisor);
+
+/* Branche l'IRQ4 : a partir de la le ring est vide par l'interruption THRE (apres idt_init) */
+void serial_enable_irq(void);
+
+/* Change la vitesse (115200 / divisor bauds) */
+void serial_set_divisor(uint16_t divisor);
+
+/* Ajoute des octets au ring d'emission ('\n' -> "\r\n") et remplit la FIFO si elle est vide. Ne boucle jamais sur le LSR */
+void serial_write(const char* data, size_t size);
+
+/* Attend que tout le ring soit sorti sur la ligne (seule fonction qui boucle sur le LSR) : avant d'arreter la machine */
+void serial_drain(void);
+
+/* Mode polle (avant les interruptions) : pousse ce qui peut l'etre dans la FIFO si elle est vide */
+void serial_poll(void);
+
+#endif
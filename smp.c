@@ -0,0 +1,343 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "acpi.h"
+#include "cpu.h"
+#include "idt.h"
+#include "log.h"
+#include "math64.h"
+#include "pmm.h"
+#include "printk.h"
+#include "smp.h"
+#include "string.h"
+#include "timer.h"
+
+/* --- Registres du local APIC (offsets dans sa page MMIO) --- */
+#define LAPIC_EOI      0x0B0
+#define LAPIC_SPURIOUS 0x0F0 // bit 8 : APIC active, bits 0-7 : vecteur parasite
+#define LAPIC_ICR_LOW  0x300 // l'ecriture envoie l'IPI
+#define LAPIC_ICR_HIGH 0x310 // bits 24-31 : APIC de destination
+#define LAPIC_LINT0    0x350
+#define LAPIC_LINT1    0x360
+
+#define LAPIC_ENABLE   0x100
+#define LVT_EXTINT     0x700 // LINT0 relie au PIC (mode "virtual wire")
+#define LVT_NMI        0x400
+#define ICR_FIXED      0x000
+#define ICR_INIT       0x500
+#define ICR_STARTUP    0x600 // le vecteur est la page de depart (adresse >> 12)
+#define ICR_ASSERT     (1u << 14)
+#define ICR_PENDING    (1u << 12) // l'IPI n'est pas encore parti
+
+/* Delais de la sequence INIT-SIPI-SIPI (Intel SDM, MultiProcessor Specification B.4) */
+static const uint32_t INIT_DELAY_US = 10000;
+static const uint32_t STARTUP_DELAY_US = 200;
+static const uint32_t AP_TIMEOUT_US = 100000; // un AP muet arrete le demarrage des suivants
+
+/* --- Charge de travail parallele --- */
+#define BENCH_BYTES (256 * 1024) // par CPU : tient dans un L2, le checksum est limite par le calcul et pas la RAM
+#define BENCH_PASSES 256
+static const uint32_t BENCH_TIMEOUT_TICKS = 10 * TIMER_HZ;
+
+SmpCpu smp_cpus[SMP_MAX_CPUS];
+uint32_t smp_cpu_count = 1;
+uint32_t smp_madt_cpus = 0;
+
+static volatile uint32_t* lapic;  // registres du local APIC (les memes adresses pour chaque CPU)
+
+/* Parametres de l'AP en cours de demarrage : pile chargee par trampoline.S, index lu par ap_main() */
+uint32_t ap_boot_stack;
+static uint32_t ap_boot_index;
+
+/* Code 16-bit recopie a SMP_TRAMPOLINE_ADDRESS (trampoline.S) */
+extern const uint8_t ap_trampoline_start[];
+extern const uint8_t ap_trampoline_end[];
+
+/* Lancement courant de smp_bench() : ecrits par le BSP avant d'incrementer job_generation */
+static uint32_t job_generation;
+static uint32_t job_cpus;
+static uint32_t job_go;    // generation liberee, une fois tous les participants reveilles et prets
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return lapic[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    lapic[reg / 4] = value;
+}
+
+/* L'ICR est propre a chaque CPU : deux CPUs peuvent envoyer des IPI en meme temps sans verrou */
+static void lapic_send_ipi(uint8_t apic_id, uint32_t command) {
+    lapic_write(LAPIC_ICR_HIGH, (uint32_t) apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, command);
+    while (lapic_read(LAPIC_ICR_LOW) & ICR_PENDING) cpu_relax();
+}
+
+/* Active le local APIC du CPU qui appelle. Les IRQ du PIC arrivent au BSP par LINT0 : si le BIOS a laisse son APIC
+   desactive, on le programme comme il l'aurait fait (LINT0 en ExtINT, LINT1 en NMI). LINT0 reste masque sur les APs */
+static void lapic_enable(int bsp) {
+    int was_enabled = (lapic_read(LAPIC_SPURIOUS) & LAPIC_ENABLE) != 0;
+    lapic_write(LAPIC_SPURIOUS, LAPIC_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    if (bsp && !was_enabled) {
+        lapic_write(LAPIC_LINT0, LVT_EXTINT);
+        lapic_write(LAPIC_LINT1, LVT_NMI);
+    }
+}
+
+static void delay_us(uint32_t us) {
+    if (tsc_khz) {
+        uint64_t end = rdtsc() + udiv64_32((uint64_t) us * tsc_khz, 1000, NULL);
+        while (rdtsc() < end) cpu_relax();
+        return;
+    }
+    /* Sans TSC : ticks du PIT (les interruptions sont actives), au moins un tick entier */
+    uint32_t start = timer_ticks;
+    uint32_t ticks = us / (1000000 / TIMER_HZ) + 2;
+    while (timer_ticks - start < ticks) cpu_relax();
+}
+
+uint32_t smp_cpu_index(void) {
+    uint16_t selector;
+    __asm__ ("mov %%gs, %0" : "=r"(selector));
+    return (uint32_t) (selector - SMP_CPU_SELECTOR(0)) / 8;
+}
+
+void smp_interrupt(uint32_t vector) {
+    if (vector != LAPIC_SPURIOUS_VECTOR) lapic_write(LAPIC_EOI, 0);
+}
+
+/* --- Files de sortie --- */
+void smp_queue_push(uint32_t cpu, int level, const char* text, size_t len) {
+    SmpQueue* queue = &smp_cpus[cpu].queue;
+    uint32_t head = queue->head;
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= SMP_QUEUE_SLOTS) {
+        queue->dropped++;
+        return;
+    }
+
+    SmpMessage* slot = &queue->slots[head & (SMP_QUEUE_SLOTS - 1)];
+    int newline = (len > 0 && text[len - 1] == '\n');
+    if (len > SMP_MESSAGE_MAX) len = SMP_MESSAGE_MAX;
+    memcpy(slot->text, text, len);
+    if (newline) slot->text[len - 1] = '\n'; // un message tronque finit quand meme sa ligne
+    slot->level = (uint8_t) level;
+    slot->len = (uint8_t) len;
+    /* Publie le slot : le BSP ne voit le nouvel head qu'une fois le message ecrit */
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+
+    /* File vide juste avant : le BSP dort peut-etre dans son hlt. Sinon il a deja de quoi se reveiller (au pire
+       il voit le message au prochain tick du PIT) : pas un IPI par message */
+    if (head == tail) lapic_send_ipi(smp_cpus[0].apic_id, ICR_FIXED | LAPIC_WAKE_VECTOR);
+}
+
+/* Les records prennent l'heure du drainage : au plus un tick de retard sur le printk de l'AP */
+void smp_drain(void) {
+    for (uint32_t cpu = 1; cpu < smp_cpu_count; cpu++) {
+        SmpQueue* queue = &smp_cpus[cpu].queue;
+        uint32_t tail = queue->tail;
+        uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        if (head == tail) continue;
+
+        for (; tail != head; tail++) {
+            const SmpMessage* slot = &queue->slots[tail & (SMP_QUEUE_SLOTS - 1)];
+            log_append(slot->level, slot->text, slot->len);
+        }
+        /* Libere les slots seulement apres les avoir recopies */
+        __atomic_store_n(&queue->tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+int smp_pending(void) {
+    for (uint32_t cpu = 1; cpu < smp_cpu_count; cpu++) {
+        if (__atomic_load_n(&smp_cpus[cpu].queue.head, __ATOMIC_ACQUIRE) != smp_cpus[cpu].queue.tail) return 1;
+    }
+    return 0;
+}
+
+/* --- Charge de travail --- */
+/* Somme de Fletcher sur des mots de 32 bits : deux sommes dependantes, limitee par le calcul */
+static uint32_t checksum_words(const uint32_t* words, size_t count) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < count; i++) {
+        a += words[i];
+        b += a;
+    }
+    return (b << 16) ^ a;
+}
+
+/* La fin est marquee avec le numero du lancement : un CPU en retard sur un lancement abandonne (delai depasse)
+   ne peut pas etre compte comme ayant fini le suivant */
+static void job_run(SmpCpu* cpu, uint32_t generation) {
+    /* Pret, puis attente du depart commun. Si le BSP a abandonne ce lancement (un autre CPU ne s'est pas reveille
+       a temps) et en a commence un autre, celui-ci est laisse tomber */
+    __atomic_store_n(&cpu->ready_generation, generation, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&job_go, __ATOMIC_ACQUIRE) != generation) {
+        if (__atomic_load_n(&job_generation, __ATOMIC_ACQUIRE) != generation) return;
+        cpu_relax();
+    }
+
+    uint64_t start = rdtsc();
+    uint32_t sum = 0;
+    for (int pass = 0; pass < BENCH_PASSES; pass++) sum += checksum_words(cpu->buffer, BENCH_BYTES / 4);
+    cpu->checksum = sum;
+    cpu->cycles = rdtsc() - start;
+    __atomic_store_n(&cpu->done_generation, generation, __ATOMIC_RELEASE);
+}
+
+/* Un buffer par CPU (pas de partage de lignes de cache), tous remplis avec le meme motif */
+static int bench_buffers(void) {
+    for (uint32_t cpu = 0; cpu < smp_cpu_count; cpu++) {
+        if (smp_cpus[cpu].buffer) continue;
+        uint32_t pages = pmm_alloc_pages(BENCH_BYTES / PAGE_SIZE);
+        if (!pages) return 0;
+        uint32_t* words = (uint32_t*) pages;
+        for (uint32_t i = 0; i < BENCH_BYTES / 4; i++) words[i] = i * 2654435761u; // hachage de Knuth
+        smp_cpus[cpu].buffer = words;
+    }
+    return 1;
+}
+
+int smp_bench(uint32_t cpus, SmpBenchResult* result) {
+    if (cpus == 0 || cpus > smp_cpu_count || !bench_buffers()) return 0;
+
+    uint32_t generation = job_generation + 1;
+    job_cpus = cpus;
+    __atomic_store_n(&job_generation, generation, __ATOMIC_RELEASE);
+    for (uint32_t cpu = 1; cpu < cpus; cpu++) lapic_send_ipi(smp_cpus[cpu].apic_id, ICR_FIXED | LAPIC_WAKE_VECTOR);
+
+    /* Depart commun : le chrono ne part qu'une fois tous les APs sortis de leur hlt, la latence de l'IPI et du
+       reveil n'est comptee ni dans le total ni dans la part de chaque CPU */
+    uint32_t ticks = timer_ticks;
+    for (uint32_t cpu = 1; cpu < cpus; cpu++) {
+        while (__atomic_load_n(&smp_cpus[cpu].ready_generation, __ATOMIC_ACQUIRE) != generation) {
+            if (timer_ticks - ticks > BENCH_TIMEOUT_TICKS) return 0;
+            cpu_relax();
+        }
+    }
+    uint64_t start = rdtsc();
+    __atomic_store_n(&job_go, generation, __ATOMIC_RELEASE);
+    job_run(&smp_cpus[0], generation);
+
+    ticks = timer_ticks;
+    for (uint32_t cpu = 1; cpu < cpus; cpu++) {
+        while (__atomic_load_n(&smp_cpus[cpu].done_generation, __ATOMIC_ACQUIRE) != generation) {
+            if (timer_ticks - ticks > BENCH_TIMEOUT_TICKS) return 0;
+            cpu_relax();
+        }
+    }
+    result->cycles = rdtsc() - start;
+    result->cpus = cpus;
+    result->bytes = (uint64_t) cpus * BENCH_BYTES * BENCH_PASSES;
+    result->checksums_match = 1;
+    for (uint32_t cpu = 1; cpu < cpus; cpu++) {
+        if (smp_cpus[cpu].checksum != smp_cpus[0].checksum) result->checksums_match = 0;
+    }
+    return 1;
+}
+
+/* --- Demarrage des APs --- */
+/* Appele par trampoline.S sur la pile de l'AP, interruptions coupees */
+void ap_main(void) {
+    uint32_t index = ap_boot_index;
+    SmpCpu* cpu = &smp_cpus[index];
+    __asm__ volatile ("mov %0, %%gs" : : "r"((uint16_t) SMP_CPU_SELECTOR(index)));
+
+    /* Arrive apres le delai : le BSP n'a pas compte ce slot, personne ne viderait sa file ni ne le reveillerait.
+       L'AP s'arrete sur sa pile (qui reste donc allouee) sans printk ni local APIC */
+    uint32_t booting = SMP_CPU_BOOTING;
+    if (!__atomic_compare_exchange_n(&cpu->state, &booting, SMP_CPU_ONLINE, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        while (1) __asm__ volatile ("cli; hlt");
+    }
+
+    /* Meme environnement que le BSP : SSE pour string.c, IDT partagee, local APIC pour recevoir l'IPI de reveil */
+    if (string_has_sse2) cpu_enable_sse();
+    idt_load();
+    lapic_enable(0);
+    printk(KERN_INFO "smp: cpu%u online (APIC ID %u)\n", index, cpu->apic_id);
+
+    /* Dort jusqu'a l'IPI de reveil d'un nouveau lancement (teste interruptions coupees, comme la boucle du BSP) */
+    uint32_t seen = 0;
+    while (1) {
+        interrupts_disable();
+        uint32_t generation = __atomic_load_n(&job_generation, __ATOMIC_ACQUIRE);
+        if (generation == seen) {
+            cpu_wait_for_interrupt();
+            continue;
+        }
+        interrupts_enable();
+        seen = generation;
+        if (index < job_cpus) job_run(cpu, generation);
+    }
+}
+
+static int ap_online(const SmpCpu* cpu) {
+    return __atomic_load_n(&cpu->state, __ATOMIC_ACQUIRE) == SMP_CPU_ONLINE;
+}
+
+/* INIT puis deux SIPI (le second seulement si le premier n'a pas suffi), puis attend que l'AP se declare en ligne */
+static int ap_start(uint8_t apic_id) {
+    uint32_t index = smp_cpu_count;
+    SmpCpu* cpu = &smp_cpus[index];
+    uint32_t stack = pmm_alloc_pages(SMP_STACK_PAGES);
+    if (!stack) {
+        printk(KERN_WARNING "smp: no memory for the stack of APIC ID %u\n", apic_id);
+        return 0;
+    }
+
+    cpu->apic_id = apic_id;
+    cpu->state = SMP_CPU_BOOTING;
+    cpu->stack = stack + SMP_STACK_PAGES * PAGE_SIZE;
+    ap_boot_index = index;
+    ap_boot_stack = cpu->stack;
+
+    lapic_send_ipi(apic_id, ICR_INIT | ICR_ASSERT);
+    delay_us(INIT_DELAY_US);
+    for (int attempt = 0; attempt < 2 && !ap_online(cpu); attempt++) {
+        lapic_send_ipi(apic_id, ICR_STARTUP | (SMP_TRAMPOLINE_ADDRESS >> 12));
+        delay_us(STARTUP_DELAY_US);
+    }
+    for (uint32_t waited = 0; waited < AP_TIMEOUT_US && !ap_online(cpu); waited += 100) {
+        delay_us(100);
+    }
+
+    /* Abandon atomique : si l'AP s'est declare entre le dernier test et ici, le CAS echoue et il est compte */
+    uint32_t booting = SMP_CPU_BOOTING;
+    if (__atomic_compare_exchange_n(&cpu->state, &booting, SMP_CPU_ABANDONED, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        printk(KERN_WARNING "smp: APIC ID %u did not start\n", apic_id);
+        return 0;
+    }
+    smp_cpu_count++;
+    return 1;
+}
+
+void smp_init(void) {
+    AcpiMadt madt;
+
+    if (!(cpuid_features_edx() & CPUID_EDX_APIC)) {
+        printk(KERN_INFO "smp: no local APIC, 1 CPU\n");
+        return;
+    }
+    uint8_t bsp_id = cpuid_initial_apic_id();
+    if (!acpi_read_madt(&madt, bsp_id)) {
+        printk(KERN_INFO "smp: no ACPI MADT, 1 CPU\n");
+        return;
+    }
+    smp_madt_cpus = madt.cpu_count + madt.ignored;
+
+    lapic = (volatile uint32_t*) madt.lapic_address;
+    smp_cpus[0].apic_id = bsp_id;
+    smp_cpus[0].state = SMP_CPU_ONLINE;
+    lapic_enable(1);
+
+    if (madt.cpu_count > 1) {
+        /* Le premier MB est reserve par pmm_init() et la structure Multiboot a deja ete lue : la page est libre */
+        memcpy((void*) SMP_TRAMPOLINE_ADDRESS, ap_trampoline_start, ap_trampoline_end - ap_trampoline_start);
+
+        /* apic_ids[0] est le BSP */
+        for (uint32_t i = 1; i < madt.cpu_count && smp_cpu_count < SMP_MAX_CPUS; i++) {
+            if (!ap_start(madt.apic_ids[i])) break;
+        }
+    }
+
+    printk(KERN_INFO "smp: %u/%u CPUs online\n", smp_cpu_count, smp_madt_cpus);
+}
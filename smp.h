@@ -0,0 +1,96 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "acpi.h"
+
+/* Multiprocesseur : les processeurs de la MADT (acpi.c) sont demarres par INIT-SIPI-SIPI depuis le BSP, chacun
+   sur sa propre pile. Le BSP reste le seul proprietaire de la console : log, terminal, ecrans et traces ne sont
+   touches que par lui. Un printk sur un AP est formate sur place puis pousse dans la file de sortie de ce CPU
+   (ring single-producer / single-consumer sans verrou), que le BSP vide dans le log a chaque console_flush() */
+
+#define SMP_MAX_CPUS ACPI_MAX_CPUS
+#define SMP_TRAMPOLINE_ADDRESS 0x8000 // page sous 1 MB ou les APs demarrent en mode reel (vecteur SIPI 0x08)
+#define SMP_STACK_PAGES 4             // 16 KiB par AP, comme la pile du BSP (boot.S)
+#define SMP_QUEUE_SLOTS 32            // messages en attente par CPU (puissance de 2)
+#define SMP_MESSAGE_MAX 126           // au-dela le message est tronque
+#define SMP_CPU_SELECTOR(cpu) (0x18 + 8 * (cpu)) // selecteur %gs du CPU (descripteurs de boot.S)
+
+/* Vecteurs du local APIC (stubs dans isr.S) */
+#define LAPIC_VECTOR_BASE     0xF0
+#define LAPIC_WAKE_VECTOR     0xF0    // IPI de reveil : sort un CPU de son hlt, rien d'autre
+#define LAPIC_SPURIOUS_VECTOR 0xFF    // interruption parasite du local APIC : pas d'EOI
+
+/* Message d'un AP : un slot de 128 octets */
+typedef struct {
+    uint8_t level;
+    uint8_t len;
+    char text[SMP_MESSAGE_MAX];
+} SmpMessage;
+
+/* File de sortie d'un CPU. Le producteur (le CPU) est le seul a ecrire head, le consommateur (le BSP) le seul a
+   ecrire tail. Un push ne fait jamais d'attente : file pleine, le message est perdu et compte.
+   head et tail sont sur deux lignes de cache : producteur et consommateur ne se disputent pas la meme */
+typedef struct {
+    SmpMessage slots[SMP_QUEUE_SLOTS];
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t dropped;   // messages perdus car la file etait pleine (ecrit par le producteur)
+    uint32_t tail __attribute__((aligned(64)));
+} SmpQueue;
+
+/* Etat d'un slot de smp_cpus : l'AP et le BSP le font passer de BOOTING a ONLINE ou ABANDONED par compare-and-swap,
+   seul le premier des deux gagne */
+#define SMP_CPU_BOOTING   0 // INIT / SIPI envoyes, l'AP ne s'est pas encore declare
+#define SMP_CPU_ONLINE    1 // l'AP est pret (pose par l'AP)
+#define SMP_CPU_ABANDONED 2 // delai depasse (pose par le BSP) : si l'AP arrive quand meme, il s'arrete sans rien toucher
+
+typedef struct {
+    uint8_t apic_id;
+    uint32_t state;     // SMP_CPU_*
+    uint32_t stack;     // haut de la pile (0 pour le BSP : pile de boot.S)
+    uint32_t* buffer;   // donnees de smp_bench(), allouees au premier lancement
+    uint32_t checksum;  // resultat du dernier smp_bench()
+    uint64_t cycles;    // duree de sa part du dernier smp_bench()
+    uint32_t ready_generation; // dernier lancement de smp_bench() pour lequel ce CPU est reveille et attend job_go
+    uint32_t done_generation; // dernier lancement de smp_bench() termine, ecrit apres checksum et cycles
+    SmpQueue queue;
+} SmpCpu;
+
+/* CPUs en ligne, BSP compris (index 0). Les APs ont les index 1 .. smp_cpu_count - 1 dans l'ordre de demarrage */
+extern SmpCpu smp_cpus[SMP_MAX_CPUS];
+extern uint32_t smp_cpu_count;
+extern uint32_t smp_madt_cpus; // processeurs actives annonces par la MADT (0 sans ACPI)
+
+/* Lit la MADT, active le local APIC du BSP et demarre les APs un par un.
+   Apres timer_calibrate_tsc() (les delais INIT / SIPI sont mesures au TSC) */
+void smp_init(void);
+
+/* Index du CPU qui appelle (0 pour le BSP), deduit du selecteur charge dans %gs : ni MMIO ni acces memoire */
+uint32_t smp_cpu_index(void);
+
+/* Producteur : ajoute un message (niveau LOG_*) a la file du CPU cpu et reveille le BSP si la file etait vide */
+void smp_queue_push(uint32_t cpu, int level, const char* text, size_t len);
+
+/* Consommateur (BSP) : vide les files des APs dans le log */
+void smp_drain(void);
+
+/* Retourne 1 si un AP a un message en attente */
+int smp_pending(void);
+
+/* Appele par isr_dispatch() pour les vecteurs >= LAPIC_VECTOR_BASE */
+void smp_interrupt(uint32_t vector);
+
+/* Resultat d'un lancement de la charge de travail parallele */
+typedef struct {
+    uint32_t cpus;      // CPUs participants (0 .. cpus - 1)
+    uint64_t bytes;     // octets lus au total
+    uint64_t cycles;    // du depart commun a la fin du dernier CPU (TSC du BSP)
+    int checksums_match; // tous les CPUs ont trouve la meme somme (memes donnees)
+} SmpBenchResult;
+
+/* Checksum des memes donnees sur les CPUs 0 .. cpus - 1 en meme temps (le BSP participe).
+   Retourne 0 si cpus est invalide, s'il n'y a pas de memoire pour les buffers ou si un CPU n'a pas fini a temps */
+int smp_bench(uint32_t cpus, SmpBenchResult* result);
+
+#endif
@@ -0,0 +1,422 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu.h"
+#include "math64.h"
+#include "printk.h"
+#include "string.h"
+
+/* En dessous de cette taille le chemin SSE2 ne rentabilise pas son alignement sur 16 octets */
+static const size_t SSE2_THRESHOLD = 512;
+
+int string_has_sse2 = 0;
+
+void string_init(void) {
+    if (cpuid_features_edx() & CPUID_EDX_SSE2) {
+        cpu_enable_sse();
+        string_has_sse2 = 1;
+    }
+}
+
+/* --- Primitives rep movs / rep stos --- */
+/* Le kernel tourne toujours avec DF = 0 (isr_common fait cld), les rep avancent donc vers les adresses hautes */
+static inline void copy_bytes(unsigned char** dst, const unsigned char** src, size_t count) {
+    __asm__ volatile ("rep movsb" : "+D"(*dst), "+S"(*src), "+c"(count) : : "memory");
+}
+
+static inline void copy_dwords(unsigned char** dst, const unsigned char** src, size_t count) {
+    __asm__ volatile ("rep movsl" : "+D"(*dst), "+S"(*src), "+c"(count) : : "memory");
+}
+
+/* memcpy : tete octet par octet jusqu'a aligner la destination sur 4, corps en rep movsd, queue octet par octet */
+static void* memcpy_movsd(void* dstptr, const void* srcptr, size_t size) {
+    unsigned char* dst = (unsigned char*) dstptr;
+    const unsigned char* src = (const unsigned char*) srcptr;
+
+    if (size >= 16) {
+        size_t head = (-(uintptr_t) dst) & 3;
+        copy_bytes(&dst, &src, head);
+        size -= head;
+        copy_dwords(&dst, &src, size >> 2);
+        size &= 3;
+    }
+    copy_bytes(&dst, &src, size);
+    return dstptr;
+}
+
+/* memcpy SSE2 : destination alignee sur 16, blocs de 64 octets (4 xmm charges avant d'ecrire, donc aussi valable en
+   recouvrement si dst < src), le reste passe par memcpy_movsd */
+__attribute__((target("sse2")))
+static void* memcpy_sse2(void* dstptr, const void* srcptr, size_t size) {
+    unsigned char* dst = (unsigned char*) dstptr;
+    const unsigned char* src = (const unsigned char*) srcptr;
+
+    size_t head = (-(uintptr_t) dst) & 15;
+    if (head > size) head = size;
+    copy_bytes(&dst, &src, head);
+    size -= head;
+
+    for (size_t blocks = size >> 6; blocks > 0; blocks--) {
+        __asm__ volatile (
+            "movdqu   (%1), %%xmm0\n\t"
+            "movdqu 16(%1), %%xmm1\n\t"
+            "movdqu 32(%1), %%xmm2\n\t"
+            "movdqu 48(%1), %%xmm3\n\t"
+            "movdqa %%xmm0,   (%0)\n\t"
+            "movdqa %%xmm1, 16(%0)\n\t"
+            "movdqa %%xmm2, 32(%0)\n\t"
+            "movdqa %%xmm3, 48(%0)\n\t"
+            : : "r"(dst), "r"(src) : "memory", "xmm0", "xmm1", "xmm2", "xmm3");
+        dst += 64;
+        src += 64;
+    }
+    memcpy_movsd(dst, src, size & 63);
+    return dstptr;
+}
+
+void* memcpy(void* dstptr, const void* srcptr, size_t size) {
+    if (string_has_sse2 && size >= SSE2_THRESHOLD) return memcpy_sse2(dstptr, srcptr, size);
+    return memcpy_movsd(dstptr, srcptr, size);
+}
+
+/* Copie descendante pour un recouvrement avec dst > src : queue octet par octet jusqu'a aligner la fin de la destination,
+   corps en rep movsd avec DF = 1 (std), puis tete octet par octet */
+static void memmove_backward(unsigned char* dst, const unsigned char* src, size_t size) {
+    unsigned char* d = dst + size;
+    const unsigned char* s = src + size;
+
+    while (size && ((uintptr_t) d & 3)) {
+        *--d = *--s;
+        size--;
+    }
+
+    size_t dwords = size >> 2;
+    if (dwords) {
+        size_t bytes = dwords << 2;
+        /* Avec DF = 1, EDI/ESI pointent sur le dernier dword a copier */
+        unsigned char* di = d - 4;
+        const unsigned char* si = s - 4;
+        __asm__ volatile ("std\n\trep movsl\n\tcld" : "+D"(di), "+S"(si), "+c"(dwords) : : "memory", "cc");
+        d -= bytes;
+        s -= bytes;
+        size -= bytes;
+    }
+
+    while (size) {
+        *--d = *--s;
+        size--;
+    }
+}
+
+void* memmove(void* dstptr, const void* srcptr, size_t size) {
+    unsigned char* dst = (unsigned char*) dstptr;
+    const unsigned char* src = (const unsigned char*) srcptr;
+
+    /* Copie montante sans risque si dst est avant src ou si les zones ne se recouvrent pas */
+    if (dst <= src || dst >= src + size) return memcpy(dstptr, srcptr, size);
+    memmove_backward(dst, src, size);
+    return dstptr;
+}
+
+/* --- Remplissage --- */
+static inline void fill_dwords(uint32_t* dst, uint32_t value, size_t count) {
+    __asm__ volatile ("rep stosl" : "+D"(dst), "+c"(count) : "a"(value) : "memory");
+}
+
+/* memset32 SSE2 : tete jusqu'a un alignement 16, blocs de 64 octets avec la valeur diffusee dans xmm0 */
+__attribute__((target("sse2")))
+static void memset32_sse2(uint32_t* dst, uint32_t value, size_t count) {
+    while (count && ((uintptr_t) dst & 15)) {
+        *dst++ = value;
+        count--;
+    }
+
+    __asm__ volatile ("movd %0, %%xmm0\n\tpshufd $0, %%xmm0, %%xmm0" : : "r"(value) : "xmm0");
+    for (size_t blocks = count >> 4; blocks > 0; blocks--) {
+        __asm__ volatile (
+            "movdqa %%xmm0,   (%0)\n\t"
+            "movdqa %%xmm0, 16(%0)\n\t"
+            "movdqa %%xmm0, 32(%0)\n\t"
+            "movdqa %%xmm0, 48(%0)\n\t"
+            : : "r"(dst) : "memory");
+        dst += 16;
+    }
+    fill_dwords(dst, value, count & 15);
+}
+
+void memset32(uint32_t* dst, uint32_t value, size_t count) {
+    if (string_has_sse2 && count * 4 >= SSE2_THRESHOLD) {
+        memset32_sse2(dst, value, count);
+        return;
+    }
+    fill_dwords(dst, value, count);
+}
+
+/* memset16 : un mot isole si la destination n'est pas alignee sur 4, puis des paires de mots en 32-bit, puis le dernier mot */
+void memset16(uint16_t* dst, uint16_t value, size_t count) {
+    if (count && ((uintptr_t) dst & 2)) {
+        *dst++ = value;
+        count--;
+    }
+    memset32((uint32_t*) dst, (uint32_t) value | ((uint32_t) value << 16), count >> 1);
+    if (count & 1) dst[count - 1] = value;
+}
+
+/* --- Expansion octets -> cellules --- */
+/* Chemin 32-bit : un mot isole si la destination n'est pas alignee sur 4, puis deux cellules par ecriture 32-bit */
+static void memexpand16_dwords(uint16_t* dst, const unsigned char* src, size_t count, uint16_t attribute) {
+    if (count && ((uintptr_t) dst & 2)) {
+        *dst++ = (uint16_t) (*src++ | attribute);
+        count--;
+    }
+
+    uint32_t attributes = (uint32_t) attribute | ((uint32_t) attribute << 16);
+    uint32_t* out = (uint32_t*) dst;
+    for (size_t pairs = count >> 1; pairs > 0; pairs--) {
+        *out++ = ((uint32_t) src[0] | ((uint32_t) src[1] << 16)) | attributes;
+        src += 2;
+    }
+    if (count & 1) *(uint16_t*) out = (uint16_t) (*src | attribute);
+}
+
+/* Chemin SSE2 : 16 octets par iteration, etendus en mots par entrelacement avec un registre nul (punpcklbw/punpckhbw)
+   puis combines avec l'attribut diffuse (por). Les cellules ne sont alignees que sur 2 : ecritures movdqu */
+__attribute__((target("sse2")))
+static void memexpand16_sse2(uint16_t* dst, const unsigned char* src, size_t count, uint16_t attribute) {
+    size_t blocks = count >> 4;
+    if (blocks) {
+        __asm__ volatile (
+            "pxor %%xmm7, %%xmm7\n\t"
+            "movd %3, %%xmm6\n\t"
+            "pshuflw $0, %%xmm6, %%xmm6\n\t"
+            "pshufd $0, %%xmm6, %%xmm6\n"
+            "1:\n\t"
+            "movdqu (%1), %%xmm0\n\t"
+            "movdqa %%xmm0, %%xmm1\n\t"
+            "punpcklbw %%xmm7, %%xmm0\n\t"
+            "punpckhbw %%xmm7, %%xmm1\n\t"
+            "por %%xmm6, %%xmm0\n\t"
+            "por %%xmm6, %%xmm1\n\t"
+            "movdqu %%xmm0, (%0)\n\t"
+            "movdqu %%xmm1, 16(%0)\n\t"
+            "add $16, %1\n\t"
+            "add $32, %0\n\t"
+            "dec %2\n\t"
+            "jnz 1b\n\t"
+            : "+r"(dst), "+r"(src), "+r"(blocks)
+            : "r"((uint32_t) attribute)
+            : "memory", "cc", "xmm0", "xmm1", "xmm6", "xmm7");
+    }
+    memexpand16_dwords(dst, src, count & 15, attribute);
+}
+
+void memexpand16(uint16_t* dst, const char* src, size_t count, uint16_t attribute) {
+    if (string_has_sse2 && count >= 16) {
+        memexpand16_sse2(dst, (const unsigned char*) src, count, attribute);
+        return;
+    }
+    memexpand16_dwords(dst, (const unsigned char*) src, count, attribute);
+}
+
+/* --- Recherche dans les cellules --- */
+static inline int cells_match(const uint16_t* cells, const unsigned char* needle, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if ((unsigned char) cells[i] != needle[i]) return 0;
+    }
+    return 1;
+}
+
+/* Reference : premier caractere teste cellule par cellule, puis comparaison complete */
+static size_t memfind16_scalar(const uint16_t* cells, size_t count, const unsigned char* needle, size_t length,
+                               size_t from) {
+    for (size_t i = from; i + length <= count; i++) {
+        if ((unsigned char) cells[i] == needle[0] && cells_match(cells + i, needle, length)) return i;
+    }
+    return count;
+}
+
+/* Chemin SSE2 : pour 8 positions a la fois, les caracteres (pand 0x00FF) sont compares au premier caractere de needle
+   et, length - 1 cellules plus loin, au dernier (pcmpeqw). Le ET des deux donne les candidats (pmovmskb, 2 bits par
+   cellule) ; l'asm rend la main au premier bloc qui en a, la verification se fait en C */
+__attribute__((target("sse2")))
+static size_t memfind16_sse2(const uint16_t* cells, size_t count, const unsigned char* needle, size_t length) {
+    size_t blocks = (count - length + 1) >> 3; // blocs de 8 positions dont toutes les lectures sont dans count
+    const uint16_t* block = cells;
+    uint32_t first = needle[0];
+    uint32_t last = needle[length - 1];
+    size_t gap = (length - 1) * sizeof(uint16_t);
+
+    while (blocks) {
+        uint32_t mask;
+        __asm__ volatile (
+            "movd %[first], %%xmm6\n\t"
+            "pshuflw $0, %%xmm6, %%xmm6\n\t"
+            "pshufd $0, %%xmm6, %%xmm6\n\t"
+            "movd %[last], %%xmm5\n\t"
+            "pshuflw $0, %%xmm5, %%xmm5\n\t"
+            "pshufd $0, %%xmm5, %%xmm5\n\t"
+            "pcmpeqw %%xmm7, %%xmm7\n\t"
+            "psrlw $8, %%xmm7\n"
+            "1:\n\t"
+            "movdqu (%[block]), %%xmm0\n\t"
+            "movdqu (%[block], %[gap]), %%xmm1\n\t"
+            "pand %%xmm7, %%xmm0\n\t"
+            "pand %%xmm7, %%xmm1\n\t"
+            "pcmpeqw %%xmm6, %%xmm0\n\t"
+            "pcmpeqw %%xmm5, %%xmm1\n\t"
+            "pand %%xmm1, %%xmm0\n\t"
+            "pmovmskb %%xmm0, %[mask]\n\t"
+            "test %[mask], %[mask]\n\t"
+            "jnz 2f\n\t"
+            "add $16, %[block]\n\t"
+            "dec %[blocks]\n\t"
+            "jnz 1b\n"
+            "2:\n\t"
+            : [block] "+r"(block), [blocks] "+r"(blocks), [mask] "=&r"(mask)
+            : [first] "rm"(first), [last] "rm"(last), [gap] "r"(gap)
+            : "memory", "cc", "xmm0", "xmm1", "xmm5", "xmm6", "xmm7");
+        if (!blocks) break;
+
+        /* Candidats du bloc : le premier et le dernier caractere correspondent deja */
+        for (size_t k = 0; k < 8; k++) {
+            if ((mask >> (2 * k)) & 1 && cells_match(block + k, needle, length)) return (size_t) (block + k - cells);
+        }
+        block += 8;
+        blocks--;
+    }
+    return memfind16_scalar(cells, count, needle, length, (size_t) (block - cells));
+}
+
+size_t memfind16(const uint16_t* cells, size_t count, const char* needle, size_t length) {
+    if (length == 0 || length > count) return count;
+    if (string_has_sse2 && count - length + 1 >= 8) {
+        return memfind16_sse2(cells, count, (const unsigned char*) needle, length);
+    }
+    return memfind16_scalar(cells, count, (const unsigned char*) needle, length, 0);
+}
+
+void* memset(void* dstptr, int value, size_t size) {
+    unsigned char* dst = (unsigned char*) dstptr;
+    unsigned char byte = (unsigned char) value;
+
+    while (size && ((uintptr_t) dst & 3)) {
+        *dst++ = byte;
+        size--;
+    }
+    memset32((uint32_t*) dst, byte * 0x01010101u, size >> 2);
+    dst += size & ~(size_t) 3;
+    for (size &= 3; size; size--) *dst++ = byte;
+    return dstptr;
+}
+
+size_t strlen(const char* str) {
+	size_t len = 0;
+	while (str[len]) len++;
+	return len;
+}
+
+int strcmp(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (unsigned char) *a - (unsigned char) *b;
+}
+
+/* --- Benchmark --- */
+#define BENCH_SIZE 8192
+#define BENCH_RUNS 8
+
+static unsigned char bench_src[BENCH_SIZE + 64] __attribute__((aligned(16)));
+static unsigned char bench_dst[BENCH_SIZE + 64] __attribute__((aligned(16)));
+
+/* Reference : l'ancien memmove du kernel, un octet par iteration */
+static void* memmove_byte_loop(void* dstptr, const void* srcptr, size_t size) {
+	unsigned char* dst = (unsigned char*) dstptr;
+	const unsigned char* src = (const unsigned char*) srcptr;
+	if (dst < src) {
+		for (size_t i = 0; i < size; i++)
+			dst[i] = src[i];
+	} else {
+		for (size_t i = size; i != 0; i--)
+			dst[i-1] = src[i-1];
+	}
+	return dstptr;
+}
+
+static void memset_byte_loop(unsigned char* dst, unsigned char value, size_t size) {
+    for (size_t i = 0; i < size; i++) dst[i] = value;
+}
+
+typedef enum {
+    BENCH_MOVE_BYTES, BENCH_MEMCPY_MOVSD, BENCH_MEMCPY_SSE2, BENCH_MEMCPY_UNALIGNED, BENCH_MEMMOVE_BACKWARD,
+    BENCH_SET_BYTES, BENCH_MEMSET32_STOSD, BENCH_MEMSET32_SSE2, BENCH_MEMSET16_VGA,
+    BENCH_EXPAND_BYTES, BENCH_EXPAND_DWORDS, BENCH_EXPAND_SSE2, BENCH_FIND_SCALAR, BENCH_FIND_SSE2, BENCH_COUNT
+} BenchVariant;
+
+static const char* bench_names[BENCH_COUNT] = {
+    "memmove (byte loop)     ",
+    "memcpy (rep movsd)      ",
+    "memcpy (sse2)           ",
+    "memcpy (unaligned dst+1)",
+    "memmove (overlap, std)  ",
+    "memset (byte loop)      ",
+    "memset32 (rep stosd)    ",
+    "memset32 (sse2)         ",
+    "memset16 (vga cells)    ",
+    "expand (byte loop)      ",
+    "expand (32-bit pairs)   ",
+    "expand (sse2)           ",
+    "find (scalar)           ",
+    "find (sse2)             ",
+};
+
+/* Motif absent des cellules du benchmark : on mesure le filtre seul, sans verification de candidats */
+static const unsigned char bench_needle[] = "kfs>";
+
+/* Reference : une cellule par caractere, comme terminal_putchar */
+static void expand_byte_loop(uint16_t* dst, const unsigned char* src, size_t count, uint16_t attribute) {
+    for (size_t i = 0; i < count; i++) dst[i] = (uint16_t) (src[i] | attribute);
+}
+
+static void bench_run(BenchVariant variant) {
+    switch (variant) {
+        case BENCH_MOVE_BYTES:       memmove_byte_loop(bench_dst, bench_src, BENCH_SIZE); break;
+        case BENCH_MEMCPY_MOVSD:     memcpy_movsd(bench_dst, bench_src, BENCH_SIZE); break;
+        case BENCH_MEMCPY_SSE2:      memcpy_sse2(bench_dst, bench_src, BENCH_SIZE); break;
+        case BENCH_MEMCPY_UNALIGNED: memcpy(bench_dst + 1, bench_src, BENCH_SIZE); break;
+        case BENCH_MEMMOVE_BACKWARD: memmove(bench_dst + 32, bench_dst, BENCH_SIZE); break;
+        case BENCH_SET_BYTES:        memset_byte_loop(bench_dst, 0x20, BENCH_SIZE); break;
+        case BENCH_MEMSET32_STOSD:   fill_dwords((uint32_t*) bench_dst, 0x07200720, BENCH_SIZE / 4); break;
+        case BENCH_MEMSET32_SSE2:    memset32_sse2((uint32_t*) bench_dst, 0x07200720, BENCH_SIZE / 4); break;
+        case BENCH_MEMSET16_VGA:     memset16((uint16_t*) bench_dst, 0x0720, BENCH_SIZE / 2); break;
+        case BENCH_EXPAND_BYTES:     expand_byte_loop((uint16_t*) bench_dst, bench_src, BENCH_SIZE / 2, 0x0700); break;
+        case BENCH_EXPAND_DWORDS:    memexpand16_dwords((uint16_t*) bench_dst, bench_src, BENCH_SIZE / 2, 0x0700); break;
+        case BENCH_EXPAND_SSE2:      memexpand16_sse2((uint16_t*) bench_dst, bench_src, BENCH_SIZE / 2, 0x0700); break;
+        case BENCH_FIND_SCALAR:      memfind16_scalar((uint16_t*) bench_dst, BENCH_SIZE / 2, bench_needle, 4, 0); break;
+        case BENCH_FIND_SSE2:        memfind16_sse2((uint16_t*) bench_dst, BENCH_SIZE / 2, bench_needle, 4); break;
+        default: break;
+    }
+}
+
+void string_benchmark(void) {
+    printk("memory benchmark: %d KB, best of %d runs, cycles per KB\n", BENCH_SIZE / 1024, BENCH_RUNS);
+
+    for (int variant = 0; variant < BENCH_COUNT; variant++) {
+        if ((variant == BENCH_MEMCPY_SSE2 || variant == BENCH_MEMSET32_SSE2 || variant == BENCH_EXPAND_SSE2
+             || variant == BENCH_FIND_SSE2) && !string_has_sse2) {
+            printk("  %s : n/a (no SSE2)\n", bench_names[variant]);
+            continue;
+        }
+
+        /* Un premier passage pour chauffer les caches, puis on garde le meilleur temps */
+        bench_run(variant);
+        uint64_t best = ~0ULL;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            uint64_t start = rdtsc();
+            bench_run(variant);
+            uint64_t cycles = rdtsc() - start;
+            if (cycles < best) best = cycles;
+        }
+        printk("  %s : %d\n", bench_names[variant], (int) udiv64_32(best, BENCH_SIZE / 1024, NULL));
+    }
+}
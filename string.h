@@ -0,0 +1,40 @@
+#ifndef STRING_H
+#define STRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bibliotheque memoire du kernel (pas de libc) :
+   - les copies/remplissages passent par rep movsd / rep stosd avec tete et queue alignees a la main
+   - si le CPU a SSE2 (CPUID) et que string_init() l'a active, les gros blocs passent par des registres xmm 128-bit */
+
+/* Detecte SSE2, active les instructions SSE (CR0/CR4) et selectionne les chemins rapides */
+void string_init(void);
+
+/* 1 si le chemin SSE2 est utilisable */
+extern int string_has_sse2;
+
+void* memcpy(void* dstptr, const void* srcptr, size_t size);
+void* memmove(void* dstptr, const void* srcptr, size_t size);
+void* memset(void* dstptr, int value, size_t size);
+
+/* Remplit count mots de 16/32 bits (ex : cellules VGA caractere + couleur) */
+void memset16(uint16_t* dst, uint16_t value, size_t count);
+void memset32(uint32_t* dst, uint32_t value, size_t count);
+
+/* Etend count caracteres en cellules VGA : dst[i] = src[i] | attribute (attribut deja decale : couleur << 8).
+   Deux cellules par ecriture 32-bit, 16 par iteration SSE2 */
+void memexpand16(uint16_t* dst, const char* src, size_t count, uint16_t attribute);
+
+/* Cherche needle (length caracteres) dans les caracteres de count cellules VGA (l'attribut est ignore).
+   Renvoie l'index de la premiere occurrence, count s'il n'y en a pas. Le chemin SSE2 filtre 8 positions par iteration
+   sur le premier et le dernier caractere, seuls les candidats sont compares en entier */
+size_t memfind16(const uint16_t* cells, size_t count, const char* needle, size_t length);
+
+size_t strlen(const char* str);
+int strcmp(const char* a, const char* b);
+
+/* Mesure chaque variante (octet par octet, rep movsd/stosd, SSE2) et affiche les cycles par KB */
+void string_benchmark(void);
+
+#endif
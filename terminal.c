@@ -0,0 +1,905 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "ansi.h"
+#include "command.h"
+#include "history.h"
+#include "keyboard.h"
+#include "line.h"
+#include "printk.h"
+#include "search.h"
+#include "string.h"
+#include "terminal.h"
+#include "trace.h"
+#include "vga.h"
+
+/* Moteur du terminal : historique, curseur, edition, ecrans et rendu par lignes sales.
+   Il ne touche au materiel qu'a travers vga.h (vga_buffer, vga_crtc_write16, vga_present) : le meme fichier se compile
+   pour l'hote avec un faux backend (tests/host.c). La vue fait vga_rows lignes (25 en mode texte, plus avec la
+   console framebuffer) */
+
+/* --- Registres CRTC (ecrits via vga_crtc_write16) --- */
+static const uint8_t CRTC_START_HIGH = 0x0C;  // Adresse de debut d'affichage (en cellules), partie haute
+static const uint8_t CRTC_START_LOW  = 0x0D;  // Adresse de debut d'affichage, partie basse
+static const uint8_t CRTC_CURSOR_HIGH = 0x0E; // Position du curseur (en cellules depuis le debut de la VRAM), partie haute
+static const uint8_t CRTC_CURSOR_LOW  = 0x0F; // Position du curseur, partie basse
+
+/* La VRAM texte fait 32 KB (16384 cellules) mais une vue n'en affiche que 2000.
+   En mode panning chaque screen garde une fenetre de VRAM_WINDOW_ROWS lignes de son historique resident dans son
+   propre slot de VRAM : scroller dans cette fenetre ou changer d'ecran ne coute qu'un changement d'adresse de debut CRTC.
+   Un slot fait VRAM_WINDOW_ROWS lignes de vga_columns cellules : 3 x 5120 <= 16384 en mode texte, 3 x 8192 dans la
+   copie en RAM de la console framebuffer (VGA_SHADOW_CELLS) */
+#define VRAM_WINDOW_ROWS 64
+#define VRAM_SLOTS 3
+
+/* --- Ecrans --- */
+/* Les ecrans n'existent qu'une fois affiches : un ecran jamais ouvert ne coute qu'un pointeur NULL */
+static Terminal* terminals[TERMINAL_MAX_SCREENS];
+static Terminal* active; // ecran affiche, tout le moteur travaille sur lui
+static terminal_alloc_t terminal_alloc;
+static size_t terminal_lines; // historique voulu par ecran
+static uint32_t show_clock;   // incremente a chaque changement d'ecran (last_shown)
+
+/* Une couleur par ecran (F1 gris, F2 vert, F3 cyan, ...) */
+static const uint8_t screen_colors[TERMINAL_MAX_SCREENS] = {
+    VGA_COLOR_LIGHT_GREY, VGA_COLOR_LIGHT_GREEN, VGA_COLOR_LIGHT_CYAN, VGA_COLOR_YELLOW,
+    VGA_COLOR_LIGHT_MAGENTA, VGA_COLOR_LIGHT_BLUE, VGA_COLOR_WHITE, VGA_COLOR_LIGHT_RED,
+    VGA_COLOR_GREEN, VGA_COLOR_CYAN, VGA_COLOR_BROWN, VGA_COLOR_MAGENTA,
+};
+
+/* --- Damage tracking --- */
+/* Plutot que de recopier les 4000 octets de la vue a chaque caractere, on note les lignes de l'historique
+   modifiees (History.dirty pour les lignes chaudes) et refresh_screen() ne recopie que les lignes sales.
+   Les lignes froides ne changent plus : seules celles passees froides avant d'etre rendues sont a recopier. */
+int full_redraw = 1; // 1 -> tout ce qui est affiche doit etre recopie au prochain rendu
+int vga_panning = 1; // 1 -> mode panning CRTC, 0 -> mode copie (la vue est recopiee au debut de la VRAM)
+size_t rendered_view_row = 0; // view_row de la vue actuellement en VRAM (mode copie)
+uint32_t rendered_first_line = 0; // first_line du screen affiche (mode copie : une ligne perdue en haut decale toute la vue)
+const Terminal* rendered_terminal = NULL; // screen actuellement en VRAM (NULL : rien n'a encore ete affiche)
+uint16_t rendered_cursor = 0xFFFF; // derniere position ecrite dans les registres curseur
+uint16_t rendered_start = 0xFFFF; // derniere adresse de debut ecrite dans le CRTC
+uint16_t display_start = 0; // adresse de debut d'affichage courante (en cellules)
+
+/* Slots VRAM du mode panning : il n'y en a que 3 pour 12 ecrans, ils vont aux ecrans affiches le plus recemment */
+static Terminal* vram_slots[VRAM_SLOTS];
+
+RenderStats render_stats;
+
+/* Cellule du heartbeat, dessinee par dessus la ligne logique 0, derniere colonne (0 : pas de heartbeat).
+   Elle n'est pas stockee dans l'historique : la ligne 0 peut etre une ligne froide, qui ne se modifie plus */
+static uint16_t heartbeat_cell = 0;
+
+/* Recherche : surbrillance des occurrences visibles et barre de saisie dessinees par dessus la vue, en VRAM seulement */
+#define SEARCH_PROMPT "search: "
+#define SEARCH_PROMPT_LENGTH (sizeof(SEARCH_PROMPT) - 1)
+#define SEARCH_NOT_FOUND "not found"
+#define SEARCH_NOT_FOUND_LENGTH (sizeof(SEARCH_NOT_FOUND) - 1)
+static const uint8_t SEARCH_MATCH_COLOR = VGA_COLOR_BLACK | VGA_COLOR_LIGHT_GREY << 4;
+static const uint8_t SEARCH_CURRENT_COLOR = VGA_COLOR_BLACK | VGA_COLOR_BROWN << 4;
+static const uint8_t SEARCH_BAR_COLOR = VGA_COLOR_WHITE | VGA_COLOR_BLUE << 4;
+
+/* --- Historique --- */
+/* Toutes les lignes manipulees par le terminal (row, view_row, input_start_row, heartbeat) sont des lignes
+   logiques : 0 = la plus ancienne de l'historique (voir history.h). */
+static inline uint16_t* screen_line(Terminal* term, size_t row) {
+    return history_line(&term->history, row);
+}
+
+static inline size_t screen_rows(Terminal* term) {
+    return history_rows(&term->history);
+}
+
+/* Marque une ligne logique comme modifiee */
+static inline void mark_row_dirty(Terminal* term, size_t row) {
+    history_mark_dirty(&term->history, row);
+}
+
+/* Force la recopie complete de ce qui est affiche au prochain rendu */
+static inline void mark_all_dirty(void) {
+    full_redraw = 1;
+}
+
+static inline int row_is_dirty(Terminal* term, size_t row) {
+    return history_row_dirty(&term->history, row);
+}
+
+/* --- CRTC --- */
+/* Programme l'adresse de debut d'affichage (registres 0x0C/0x0D) si elle a change */
+static void vga_set_start(uint16_t start) {
+    display_start = start;
+    if (start == rendered_start) return;
+    rendered_start = start;
+    vga_crtc_write16(CRTC_START_HIGH, CRTC_START_LOW, start);
+}
+
+/* Debut (en cellules) d'un slot VRAM */
+static inline size_t vram_slot_base(int slot) {
+    return (size_t) slot * VRAM_WINDOW_ROWS * vga_columns;
+}
+
+/* Donne un slot VRAM a l'ecran : un slot libre, sinon celui de l'ecran affiche le moins recemment (qui devra etre
+   recopie en entier quand il reviendra) */
+static int vram_slot_acquire(Terminal* term) {
+    if (term->vram_slot >= 0) return term->vram_slot;
+
+    int slot = -1;
+    for (int i = 0; i < VRAM_SLOTS && slot < 0; i++) {
+        if (!vram_slots[i]) slot = i;
+    }
+    if (slot < 0) {
+        slot = 0;
+        for (int i = 1; i < VRAM_SLOTS; i++) {
+            if (vram_slots[i]->last_shown < vram_slots[slot]->last_shown) slot = i;
+        }
+        vram_slots[slot]->vram_slot = -1;
+        vram_slots[slot]->vram_valid = 0;
+    }
+    vram_slots[slot] = term;
+    term->vram_slot = slot;
+    term->vram_valid = 0;
+    return slot;
+}
+
+/* --- Hardware Cursor --- */
+/* Actualise la position du curseur */
+static void update_cursor(Terminal* term) {
+    TRACE_SCOPE(TRACE_CURSOR);
+    int x = term->column;
+    /* Calcul la position du cursor par rapport a la view actuel*/
+    int physical_row = (int) term->row - (int) term->view_row;
+    uint16_t pos;
+    
+    if (term->search.active) {
+        /* Pendant une recherche le curseur est dans la barre, apres le motif */
+        pos = display_start + (vga_rows - 1) * vga_columns + SEARCH_PROMPT_LENGTH + term->search.length;
+    /* Si la ROW est entre 0 et vga_rows - 1 on est dans l'ecran*/
+    } else if (physical_row >= 0 && physical_row < (int) vga_rows) {
+        /* Le registre curseur est une position absolue en VRAM : on part de l'origine d'affichage (panning)
+           + pos du curseur * vga_columns(tableau en 1D) + x(terminal column)*/
+        pos = display_start + physical_row * vga_columns + x;
+    } else {
+        /* Cache le curseur si il est hors screen (juste apres la derniere cellule affichee) */
+        pos = display_start + vga_columns * vga_rows;
+    }
+    /* Rien a faire si le curseur n'a pas bouge depuis le dernier rendu (evite 4 outb) */
+    if (pos == rendered_cursor) return;
+    rendered_cursor = pos;
+    render_stats.cursor_writes++;
+    /* On doit ecrire la position du curseur dans 0x0F pour la partie basse et 0x0E pour la partie haute car le curseur peut etre place plus loin que 255 donc besoint de 2 octects */
+    vga_crtc_write16(CRTC_CURSOR_HIGH, CRTC_CURSOR_LOW, pos);
+}
+
+/* Recopie une ligne logique de l'historique dans la VRAM (ou une ligne vide si elle n'existe pas) */
+static uint32_t render_row(Terminal* term, int row, uint16_t* dst) {
+    if (row >= 0 && row < (int) screen_rows(term)) {
+        /* Ligne chaude recopiee, ligne froide decodee directement en VRAM */
+        history_copy_line(&term->history, row, dst);
+        if (row == 0 && heartbeat_cell) dst[vga_columns - 1] = heartbeat_cell;
+        /* Seules les lignes de la vue sont surlignees : la fenetre du mode panning garde les cellules d'origine */
+        if (term->search.active && row >= (int) term->view_row && row < (int) (term->view_row + vga_rows)) {
+            search_highlight(&term->search, dst, vga_columns, row, SEARCH_MATCH_COLOR, SEARCH_CURRENT_COLOR);
+        }
+    } else {
+        memset16(dst, vga_entry(0, term->default_color), vga_columns);
+    }
+    return vga_columns;
+}
+
+/* Mode copie : la vue est recopiee au debut de la VRAM (adresse de debut 0) */
+static uint32_t render_copy(Terminal* term) {
+    uint32_t cells = 0;
+
+    /* La vue a bouge, l'historique a scrolle ou on a change d'ecran : toute la vue est a recopier */
+    if (term->view_row != rendered_view_row || term != rendered_terminal || term->history.first_line != rendered_first_line) {
+        mark_all_dirty();
+    }
+
+    for (size_t y = 0; y < vga_rows; y++) {
+        size_t row = term->view_row + y;
+        if (!full_redraw && !row_is_dirty(term, row)) continue;
+        cells += render_row(term, row, &vga_buffer[y * vga_columns]);
+    }
+    vga_set_start(0);
+    return cells;
+}
+
+/* Mode panning : la fenetre residente du screen est tenue a jour dans son slot, la vue n'est qu'une adresse de debut.
+   Si la vue sort de la fenetre, on la recentre (la vue en haut si on descend, en bas si on remonte) et on recopie
+   tout le slot : avec 64 lignes de fenetre cela arrive une fois toutes les 39 lignes de scroll */
+static uint32_t render_panned(Terminal* term) {
+    size_t base = vram_slot_base(vram_slot_acquire(term));
+    uint16_t* slot = &vga_buffer[base];
+    int view = (int) term->view_row;
+    int rebase = full_redraw || !term->vram_valid;
+    uint32_t cells = 0;
+
+    if (!rebase && view < term->vram_top) {
+        term->vram_top = view + (int) vga_rows - VRAM_WINDOW_ROWS;
+        if (term->vram_top < 0) term->vram_top = 0;
+        rebase = 1;
+    } else if (!rebase && view + (int) vga_rows > term->vram_top + VRAM_WINDOW_ROWS) {
+        term->vram_top = view;
+        rebase = 1;
+    } else if (rebase && (view < term->vram_top || view + (int) vga_rows > term->vram_top + VRAM_WINDOW_ROWS)) {
+        term->vram_top = view;
+    }
+
+    for (int y = 0; y < VRAM_WINDOW_ROWS; y++) {
+        int row = term->vram_top + y;
+        if (!rebase && (row < 0 || row >= (int) screen_rows(term) || !row_is_dirty(term, row))) continue;
+        cells += render_row(term, row, &slot[y * vga_columns]);
+    }
+    term->vram_valid = 1;
+
+    vga_set_start(base + (view - term->vram_top) * vga_columns);
+    return cells;
+}
+
+/* Barre de recherche sur la derniere ligne de la vue : motif, et "not found" s'il n'a pas d'occurrence */
+static uint32_t render_search_bar(Terminal* term) {
+    uint16_t* bar = &vga_buffer[display_start + (vga_rows - 1) * vga_columns];
+    uint16_t attribute = (uint16_t) (SEARCH_BAR_COLOR << 8);
+
+    memset16(bar, vga_entry(' ', SEARCH_BAR_COLOR), vga_columns);
+    memexpand16(bar, SEARCH_PROMPT, SEARCH_PROMPT_LENGTH, attribute);
+    memexpand16(bar + SEARCH_PROMPT_LENGTH, term->search.query, term->search.length, attribute);
+    if (term->search.length && !term->search.found) {
+        memexpand16(bar + vga_columns - SEARCH_NOT_FOUND_LENGTH, SEARCH_NOT_FOUND, SEARCH_NOT_FOUND_LENGTH, attribute);
+    }
+    return vga_columns;
+}
+
+/* Met a jour la VRAM avec les lignes modifiees depuis le dernier rendu.
+   Appelee une seule fois a la fin de terminal_write / printk / keyboard_handler */
+void refresh_screen(void) {
+    TRACE_SCOPE(TRACE_REFRESH);
+    Terminal* term = active;
+
+    /* La surbrillance et la barre ne sont pas dans l'historique : pendant une recherche toute la vue est refaite */
+    if (term->search.active) mark_all_dirty();
+    uint32_t cells = vga_panning ? render_panned(term) : render_copy(term);
+    if (term->search.active) cells += render_search_bar(term);
+
+    /* Les lignes sales hors de ce qui est en VRAM seront recopiees quand la vue (ou la fenetre) bougera */
+    history_clear_dirty(&term->history);
+    full_redraw = 0;
+    rendered_view_row = term->view_row;
+    rendered_first_line = term->history.first_line;
+    rendered_terminal = term;
+
+    render_stats.flushes++;
+    render_stats.cells_written += cells;
+    render_stats.last_cells = cells;
+    if (cells > render_stats.max_cells) render_stats.max_cells = cells;
+
+    /* Update du curseur */
+    update_cursor(term);
+    vga_present();
+}
+
+/* Passe du mode panning au mode copie (ou l'inverse) : le contenu de la VRAM n'est plus valide pour aucun screen */
+void terminal_set_panning(int enabled) {
+    vga_panning = enabled ? 1 : 0;
+    for (int i = 0; i < TERMINAL_MAX_SCREENS; i++) {
+        if (terminals[i]) terminals[i]->vram_valid = 0;
+    }
+    mark_all_dirty();
+    refresh_screen();
+}
+
+/* Recopie une cellule du screen actif directement en VRAM si sa ligne est visible, sinon la ligne est marquee sale
+   et sera recopiee quand elle entrera dans la vue (ou la fenetre residente) */
+static void render_cell(size_t row, size_t col) {
+    Terminal* term = active;
+    if (rendered_terminal != term || row < rendered_view_row || row >= rendered_view_row + vga_rows) {
+        mark_row_dirty(term, row);
+        return;
+    }
+    uint16_t entry = (row == 0 && col == vga_columns - 1 && heartbeat_cell) ? heartbeat_cell : screen_line(term, row)[col];
+    vga_buffer[display_start + (row - rendered_view_row) * vga_columns + col] = entry;
+}
+
+/* Alloue et vide un ecran. Si l'historique demande ne tient pas, on se contente du minimum */
+static Terminal* terminal_create(int index) {
+    size_t lines = terminal_lines;
+    uint8_t* storage = terminal_alloc(TERMINAL_STORAGE_SIZE(lines, vga_columns));
+    if (!storage && lines > TERMINAL_MIN_HISTORY) {
+        lines = TERMINAL_MIN_HISTORY;
+        storage = terminal_alloc(TERMINAL_STORAGE_SIZE(lines, vga_columns));
+    }
+    if (!storage) return NULL;
+
+    Terminal* term = (Terminal*) storage;
+    term->index = index;
+    term->row = 0;
+    term->column = 0;
+    term->view_row = 0;
+    term->color = vga_entry_color(screen_colors[index], VGA_COLOR_BLACK);
+    term->default_color = term->color;
+    term->sgr = 0;
+    ansi_init(&term->ansi);
+    term->page_top = 0;
+    term->saved_row = term->saved_column = 0;
+    term->saved_color = term->color;
+    term->saved_sgr = 0;
+    term->input_start_row = 0;
+    term->input_start_col = 0;
+    line_init(&term->line);
+    term->search.active = 0;
+    term->search.length = 0;
+    term->lines = lines;
+    term->vram_slot = -1;
+    term->vram_top = 0;
+    term->vram_valid = 0;
+    term->last_shown = 0;
+    /* L'historique suit le Terminal dans la meme allocation */
+    history_init(&term->history, storage + TERMINAL_HEADER_SIZE, lines, vga_columns, vga_entry(0, term->default_color));
+
+    terminals[index] = term;
+    return term;
+}
+
+void terminal_initialize(size_t lines, terminal_alloc_t alloc) {
+    /* Etat de rendu : rien n'est encore affiche */
+    full_redraw = 1;
+    rendered_view_row = 0;
+    rendered_first_line = 0;
+    rendered_terminal = NULL;
+    rendered_cursor = 0xFFFF;
+    rendered_start = 0xFFFF;
+    display_start = 0;
+    heartbeat_cell = 0;
+
+    /* Aucun ecran tant qu'il n'a pas ete affiche */
+    for (int i = 0; i < TERMINAL_MAX_SCREENS; i++) terminals[i] = NULL;
+    for (int i = 0; i < VRAM_SLOTS; i++) vram_slots[i] = NULL;
+    terminal_alloc = alloc;
+    terminal_lines = (lines > TERMINAL_MIN_HISTORY) ? lines : TERMINAL_MIN_HISTORY;
+    show_clock = 0;
+
+    /* Commence sur F1 : l'allocateur du kernel garde une reserve statique pour que celui-ci existe toujours */
+    active = terminal_create(0);
+    refresh_screen();
+}
+
+Terminal* terminal_get(int index) {
+    if (index < 0 || index >= TERMINAL_MAX_SCREENS) return NULL;
+    return terminals[index];
+}
+
+Terminal* terminal_active(void) {
+    return active;
+}
+
+/* Fait suivre la vue au curseur s'il en est sorti (par le haut ou par le bas) */
+static void follow_cursor(Terminal* term) {
+    if (term->row >= term->view_row + vga_rows) term->view_row = term->row - vga_rows + 1;
+    if (term->row < term->view_row) term->view_row = term->row;
+}
+
+/* La page adressee par les sequences ANSI est celle des vga_rows dernieres lignes atteintes par le curseur */
+static void sync_page(Terminal* term) {
+    if (term->row >= term->page_top + vga_rows) term->page_top = term->row - vga_rows + 1;
+}
+
+/* logique de scroll:
+   1. Si on descend mais qu'on reste dans les limites de l'historique, on défile le VIEWPORT.
+   2. Si on atteint la fin des lignes chaudes, la plus ancienne passe dans le store froid (ou est oubliee) */
+static void terminal_scroll(Terminal* term) {
+    TRACE_SCOPE(TRACE_SCROLL);
+    
+    /* Si on est plus dans l'historique on libere une ligne en bas */
+    if (term->row >= screen_rows(term)) {
+
+        /* Pas de recopie des lignes chaudes : la ligne physique de la plus ancienne devient la nouvelle derniere (videe) */
+        size_t dropped = history_push(&term->history, vga_entry(0, term->color));
+
+        /* Si des lignes ont ete oubliees en haut, toutes les lignes logiques reculent d'autant : curseur, zone read-only
+           et fenetre VRAM (son contenu reste valide). En mode copie refresh_screen() voit que first_line a change */
+        term->row -= dropped;
+        term->page_top = (term->page_top > dropped) ? term->page_top - dropped : 0;
+        term->input_start_row = (term->input_start_row > dropped) ? term->input_start_row - dropped : 0;
+        term->search.row = (term->search.row > dropped) ? term->search.row - dropped : 0;
+        term->search.origin_view = (term->search.origin_view > dropped) ? term->search.origin_view - dropped : 0;
+        term->vram_top -= (int) dropped;
+
+        /* Une saisie tres longue dont le debut est passe froid : ce debut devient read-only */
+        if (term->input_start_row < term->history.cold_count) {
+            term->input_start_row = term->history.cold_count;
+            term->input_start_col = 0;
+        }
+    }
+    
+    /* SI le curseur est hors vue decale la view pour le faire apparaitre */
+    if (term->row >= term->view_row + vga_rows) {
+        term->view_row = term->row - vga_rows + 1;
+    }
+}
+
+
+
+/* La saisie commence au curseur (apres le prompt), tout ce qui est avant est read-only */
+void set_input_boundary(void) {
+    Terminal* term = active;
+    term->input_start_row = term->row;
+    term->input_start_col = term->column;
+    line_reset(&term->line);
+}
+
+/* Apres une ecriture : retour a la ligne si la ligne est complete, puis scroll si le curseur sort de l'historique
+   ou de la vue */
+static void terminal_advance(Terminal* term) {
+    /* Retour a la ligne si on a une ligne complete */
+	if (term->column >= vga_columns) {
+		term->column = 0;
+		term->row++;
+	}
+    
+    /* SI on a plus de ligne que de place dans le buffer on supprime la plus ancienne et on ajoute la nouvelle */
+    if (term->row >= screen_rows(term)) {
+		terminal_scroll(term); // Hard shift
+    /* Encore de la place dans l'historique mais on depasse la vue de vga_rows lignes */
+	} else if (term->row >= term->view_row + vga_rows) {
+        terminal_scroll(term); // View shift
+    }
+
+    sync_page(term);
+}
+
+/* --- Sequences d'echappement --- */
+/* ansi.c reconnait les sequences, leur effet est applique ici par des tables indexees sur l'octet final.
+   Les lignes et colonnes des sequences sont relatives a la page (page_top) : le scrollback au dessus n'est jamais
+   modifie, et une mise a jour en place (CUP puis quelques caracteres) ne salit que les lignes touchees */
+typedef void (*ansi_handler_t)(Terminal* term, const AnsiParser* parser);
+
+/* Ordre des couleurs ANSI (noir, rouge, vert, jaune, bleu, magenta, cyan, blanc) vers celui de la VGA */
+static const uint8_t ansi_colors[8] = {
+    VGA_COLOR_BLACK, VGA_COLOR_RED, VGA_COLOR_GREEN, VGA_COLOR_BROWN,
+    VGA_COLOR_BLUE, VGA_COLOR_MAGENTA, VGA_COLOR_CYAN, VGA_COLOR_LIGHT_GREY,
+};
+
+static inline uint8_t swap_nibbles(uint8_t color) {
+    return (uint8_t) ((color << 4) | (color >> 4));
+}
+
+/* Place le curseur dans la page (bornes comprises) */
+static void ansi_move(Terminal* term, int row, int column) {
+    if (row < 0) row = 0;
+    if (row >= (int) vga_rows) row = vga_rows - 1;
+    if (column < 0) column = 0;
+    if (column >= (int) vga_columns) column = vga_columns - 1;
+    term->row = term->page_top + (size_t) row;
+    term->column = (size_t) column;
+    follow_cursor(term);
+}
+
+/* Efface les colonnes [from, to) d'une ligne de la page. La saisie en cours (apres la limite read-only) appartient a
+   l'editeur de ligne : elle n'est jamais effacee */
+static void ansi_erase(Terminal* term, size_t row, size_t from, size_t to) {
+    if (line_length(&term->line) > 0 && row >= term->input_start_row) {
+        if (row > term->input_start_row) return;
+        if (to > term->input_start_col) to = term->input_start_col;
+    }
+    if (from >= to) return;
+    memset16(&screen_line(term, row)[from], vga_entry(0, term->color), to - from);
+    mark_row_dirty(term, row);
+}
+
+/* CUU / CUD / CUF / CUB / CHA / CUP */
+static void csi_cursor_up(Terminal* term, const AnsiParser* parser) {
+    ansi_move(term, (int) (term->row - term->page_top) - ansi_param(parser, 0, 1), (int) term->column);
+}
+
+static void csi_cursor_down(Terminal* term, const AnsiParser* parser) {
+    ansi_move(term, (int) (term->row - term->page_top) + ansi_param(parser, 0, 1), (int) term->column);
+}
+
+static void csi_cursor_forward(Terminal* term, const AnsiParser* parser) {
+    ansi_move(term, (int) (term->row - term->page_top), (int) term->column + ansi_param(parser, 0, 1));
+}
+
+static void csi_cursor_back(Terminal* term, const AnsiParser* parser) {
+    ansi_move(term, (int) (term->row - term->page_top), (int) term->column - ansi_param(parser, 0, 1));
+}
+
+static void csi_cursor_column(Terminal* term, const AnsiParser* parser) {
+    ansi_move(term, (int) (term->row - term->page_top), ansi_param(parser, 0, 1) - 1);
+}
+
+static void csi_cursor_position(Terminal* term, const AnsiParser* parser) {
+    ansi_move(term, ansi_param(parser, 0, 1) - 1, ansi_param(parser, 1, 1) - 1);
+}
+
+/* ED : 0 du curseur a la fin de la page, 1 du debut de la page au curseur, 2 toute la page (le curseur ne bouge pas) */
+static void csi_erase_display(Terminal* term, const AnsiParser* parser) {
+    uint16_t mode = ansi_param(parser, 0, 0);
+    size_t last = term->page_top + vga_rows;
+
+    if (mode == 0) {
+        ansi_erase(term, term->row, term->column, vga_columns);
+        for (size_t row = term->row + 1; row < last; row++) ansi_erase(term, row, 0, vga_columns);
+    } else if (mode == 1) {
+        for (size_t row = term->page_top; row < term->row; row++) ansi_erase(term, row, 0, vga_columns);
+        ansi_erase(term, term->row, 0, term->column + 1);
+    } else if (mode == 2) {
+        for (size_t row = term->page_top; row < last; row++) ansi_erase(term, row, 0, vga_columns);
+    }
+}
+
+/* EL : 0 du curseur a la fin de la ligne, 1 du debut au curseur, 2 toute la ligne */
+static void csi_erase_line(Terminal* term, const AnsiParser* parser) {
+    uint16_t mode = ansi_param(parser, 0, 0);
+    if (mode == 0) ansi_erase(term, term->row, term->column, vga_columns);
+    else if (mode == 1) ansi_erase(term, term->row, 0, term->column + 1);
+    else if (mode == 2) ansi_erase(term, term->row, 0, vga_columns);
+}
+
+/* SGR : 0 reset, 1/22 clair, 7/27 inverse, 30-37/90-97 premier plan, 40-47/100-107 fond, 39/49 couleurs de l'ecran.
+   Le fond clair (100-107) utilise le bit 7 de l'attribut : clignotant si le mode blink de la VGA est actif */
+static void csi_sgr(Terminal* term, const AnsiParser* parser) {
+    uint8_t color = (term->sgr & TERMINAL_SGR_REVERSE) ? swap_nibbles(term->color) : term->color;
+    uint8_t fg = color & 0x0F;
+    uint8_t bg = color >> 4;
+    size_t count = parser->count ? parser->count : 1; // ESC[m = ESC[0m
+
+    for (size_t i = 0; i < count; i++) {
+        uint16_t code = (i < parser->count) ? parser->params[i] : 0;
+        if (code == 0) {
+            fg = term->default_color & 0x0F;
+            bg = term->default_color >> 4;
+            term->sgr = 0;
+        } else if (code == 1) {
+            term->sgr |= TERMINAL_SGR_BOLD;
+            fg |= 0x08;
+        } else if (code == 22) {
+            term->sgr &= (uint8_t) ~TERMINAL_SGR_BOLD;
+            fg &= 0x07;
+        } else if (code == 7) {
+            term->sgr |= TERMINAL_SGR_REVERSE;
+        } else if (code == 27) {
+            term->sgr &= (uint8_t) ~TERMINAL_SGR_REVERSE;
+        } else if (code >= 30 && code <= 37) {
+            fg = ansi_colors[code - 30] | ((term->sgr & TERMINAL_SGR_BOLD) ? 0x08 : 0);
+        } else if (code == 39) {
+            fg = term->default_color & 0x0F;
+        } else if (code >= 40 && code <= 47) {
+            bg = ansi_colors[code - 40];
+        } else if (code == 49) {
+            bg = term->default_color >> 4;
+        } else if (code >= 90 && code <= 97) {
+            fg = ansi_colors[code - 90] | 0x08;
+        } else if (code >= 100 && code <= 107) {
+            bg = ansi_colors[code - 100] | 0x08;
+        }
+    }
+
+    color = (uint8_t) (fg | (bg << 4));
+    term->color = (term->sgr & TERMINAL_SGR_REVERSE) ? swap_nibbles(color) : color;
+}
+
+/* DECSC / DECRC (ESC 7 / ESC 8) et leurs equivalents CSI s / CSI u : position dans la page et attributs */
+static void ansi_save_cursor(Terminal* term, const AnsiParser* parser) {
+    (void) parser;
+    term->saved_row = term->row - term->page_top;
+    term->saved_column = term->column;
+    term->saved_color = term->color;
+    term->saved_sgr = term->sgr;
+}
+
+static void ansi_restore_cursor(Terminal* term, const AnsiParser* parser) {
+    (void) parser;
+    term->color = term->saved_color;
+    term->sgr = term->saved_sgr;
+    ansi_move(term, (int) term->saved_row, (int) term->saved_column);
+}
+
+static const ansi_handler_t csi_handlers[128] = {
+    ['A'] = csi_cursor_up, ['B'] = csi_cursor_down, ['C'] = csi_cursor_forward, ['D'] = csi_cursor_back,
+    ['G'] = csi_cursor_column, ['H'] = csi_cursor_position, ['f'] = csi_cursor_position,
+    ['J'] = csi_erase_display, ['K'] = csi_erase_line, ['m'] = csi_sgr,
+    ['s'] = ansi_save_cursor, ['u'] = ansi_restore_cursor,
+};
+
+static const ansi_handler_t esc_handlers[128] = {
+    ['7'] = ansi_save_cursor, ['8'] = ansi_restore_cursor,
+};
+
+/* Applique une sequence terminee. Les sequences inconnues et les modes prives (ESC[?25l...) sont ignores */
+static void ansi_dispatch(Terminal* term, AnsiAction action) {
+    const AnsiParser* parser = &term->ansi;
+    ansi_handler_t handler = NULL;
+
+    sync_page(term); // le curseur a pu descendre par l'editeur de ligne depuis la derniere sortie
+    if (action == ANSI_CSI_DISPATCH && !parser->private_mark) handler = csi_handlers[parser->final & 0x7F];
+    else if (action == ANSI_ESC_DISPATCH) handler = esc_handlers[parser->final & 0x7F];
+    if (handler) handler(term, parser);
+}
+
+void terminal_putchar(char c) {
+    TRACE_SCOPE(TRACE_PUTCHAR);
+    Terminal* term = active;
+
+    AnsiAction action = ansi_feed(&term->ansi, (uint8_t) c);
+    if (action != ANSI_PRINT) {
+        if (action != ANSI_NONE) ansi_dispatch(term, action);
+        return;
+    }
+
+    uint16_t* line = screen_line(term, term->row);
+
+    /* Si retour a la ligne on passe a la ligne suivante */
+	if (c == '\n') {
+		term->row++;
+		term->column = 0;
+    /* Backspace dans la sortie : recule d'une cellule sur la ligne et l'efface.
+       L'edition de la saisie ne passe pas par ici (voir line.c et input_render) */
+	} else if (c == '\b') {
+        if (term->column > 0) {
+            term->column--;
+            line[term->column] = vga_entry(0, term->color);
+            mark_row_dirty(term, term->row);
+        }
+    } else {
+		line[term->column] = vga_entry(c, term->color);
+		mark_row_dirty(term, term->row);
+		term->column++;
+	}
+    terminal_advance(term);
+    /* Pas de rendu ici : c'est l'appelant (terminal_write, printk, keyboard_handler) qui fait un seul refresh_screen() a la fin */
+}
+
+/* Ecrit un run de caracteres imprimables qui tient sur la ligne du curseur : une seule expansion en cellules
+   (memexpand16), une seule ligne sale, un seul test de retour a la ligne et de scroll pour tout le run */
+static void terminal_put_run(Terminal* term, const char* text, size_t count) {
+    TRACE_SCOPE(TRACE_RUN);
+    uint16_t* line = screen_line(term, term->row);
+
+    memexpand16(&line[term->column], text, count, (uint16_t) (term->color << 8));
+    mark_row_dirty(term, term->row);
+    term->column += count;
+    terminal_advance(term);
+}
+
+/* Ecrit sans rendre : l'appelant fait un seul refresh_screen() pour tout ce qu'il a ecrit.
+   Le texte est decoupe en runs de caracteres imprimables (jusqu'au prochain octet de controle ou a la fin de la ligne),
+   les octets de controle passent par terminal_putchar */
+void terminal_append(const char* data, size_t size) {
+    Terminal* term = active;
+    size_t i = 0;
+
+    while (i < size) {
+        size_t room = vga_columns - term->column;
+        size_t end = (size - i < room) ? size : i + room;
+        size_t run = i;
+        /* Pas de run au milieu d'une sequence d'echappement : ses octets vont au decodeur */
+        if (term->ansi.state == ANSI_GROUND) {
+            while (run < end && (unsigned char) data[run] >= ' ') run++;
+        }
+
+        if (run == i) {
+            terminal_putchar(data[i++]);
+        } else {
+            terminal_put_run(term, &data[i], run - i);
+            i = run;
+        }
+    }
+}
+
+void terminal_write(const char* data, size_t size) {
+	terminal_append(data, size);
+	refresh_screen();
+}
+
+void terminal_writestring(const char* data) {
+	terminal_write(data, strlen(data));
+}
+
+int switch_screen(int screen_index) {
+    TRACE_SCOPE(TRACE_SWITCH);
+    if (screen_index < 0 || screen_index >= TERMINAL_MAX_SCREENS) return 0;
+
+    /* Premier affichage : l'ecran est alloue et vide maintenant */
+    Terminal* next = terminals[screen_index];
+    if (!next) next = terminal_create(screen_index);
+    if (!next) return 0;
+
+    /* Rien a sauvegarder ni a restaurer : tout l'etat est dans le Terminal */
+    active = next;
+    active->last_shown = ++show_clock;
+    /* Le rendu est fait par keyboard_handler : en mode panning la fenetre du screen est deja en VRAM (si son slot
+       ne lui a pas ete repris), seules l'adresse de debut CRTC et les lignes sales changent */
+    return 1;
+}
+
+/* --- Saisie --- */
+/* La saisie est dans le gap buffer de l'ecran (term->line). Elle est dessinee a partir de la limite read-only
+   (input_start_row, input_start_col) et se replie sur les lignes suivantes : le caractere index est a l'offset
+   input_start_col + index de la ligne input_start_row */
+
+/* Cree en bas de l'historique les lignes necessaires pour afficher end caracteres de saisie (et le curseur apres) */
+static void input_reserve(Terminal* term, size_t end) {
+    while (term->input_start_row + (term->input_start_col + end) / vga_columns >= screen_rows(term)) {
+        term->row = screen_rows(term);
+        terminal_scroll(term); // decale aussi input_start_row si des lignes sont perdues en haut
+    }
+}
+
+/* Place le curseur du terminal sur celui de la saisie et fait suivre la vue */
+static void input_place_cursor(Terminal* term) {
+    size_t offset = term->input_start_col + line_cursor(&term->line);
+    term->row = term->input_start_row + offset / vga_columns;
+    term->column = offset % vga_columns;
+
+    follow_cursor(term);
+}
+
+/* Redessine la saisie a partir du caractere from : seules ces cellules changent. Les cellules entre la nouvelle
+   longueur et old_len (l'ancienne) sont effacees */
+static void input_render(Terminal* term, size_t from, size_t old_len) {
+    LineEditor* line = &term->line;
+    size_t len = line_length(line);
+    size_t end = (len > old_len) ? len : old_len;
+    size_t dirty_row = (size_t) -1;
+    uint16_t* cells = NULL;
+
+    input_reserve(term, len);
+    for (size_t i = from; i < end; i++) {
+        size_t offset = term->input_start_col + i;
+        size_t row = term->input_start_row + offset / vga_columns;
+        if (row != dirty_row) {
+            cells = screen_line(term, row);
+            mark_row_dirty(term, row);
+            dirty_row = row;
+        }
+        cells[offset % vga_columns] = vga_entry((i < len) ? line_char(line, i) : 0, term->color);
+    }
+    input_place_cursor(term);
+}
+
+/* Entree : la ligne est envoyee a command_execute() et ajoutee a l'historique des commandes, puis la sortie de la
+   commande et la saisie deviennent read-only */
+static void input_submit(Terminal* term) {
+    char text[LINE_INPUT_MAX];
+    size_t len = line_length(&term->line);
+
+    line_get(&term->line, text);
+    line_history_push(&term->line, text);
+
+    /* Le curseur passe apres la fin de la saisie avant le retour a la ligne. Si elle remplit exactement sa derniere
+       ligne, le curseur est deja au debut de la suivante : le retour a la ligne termine la ligne pleine */
+    line_move(&term->line, len);
+    input_place_cursor(term);
+    if (len > 0 && term->column == 0) {
+        term->row--;
+        term->column = vga_columns - 1;
+    }
+    terminal_putchar('\n');
+
+    command_execute(text);
+    /* La sortie de la commande est dans le ring de log : elle doit etre a l'ecran avant de poser la nouvelle limite */
+    console_flush();
+    set_input_boundary();
+}
+
+/* --- Defilement de la vue --- */
+/* PageUp / PageDown : une page (vga_rows lignes) a la fois, bornee au haut et au bas de l'historique */
+static void view_page_up(Terminal* term) {
+    term->view_row -= (term->view_row < vga_rows) ? term->view_row : vga_rows;
+}
+
+static size_t view_max(Terminal* term) {
+    size_t rows = screen_rows(term);
+    return (rows > vga_rows) ? rows - vga_rows : 0;
+}
+
+static void view_page_down(Terminal* term) {
+    size_t max = view_max(term);
+    if (term->view_row >= max) return;
+    term->view_row = (term->view_row + vga_rows < max) ? term->view_row + vga_rows : max;
+}
+
+/* --- Recherche (Ctrl+F) --- */
+#define CTRL(c) ((c) & 0x1F)
+
+/* Amene l'occurrence courante dans la vue (au milieu) si elle est hors ecran ou sous la barre */
+static void search_show(Terminal* term) {
+    Search* search = &term->search;
+    if (!search->found) return;
+    if (search->row >= term->view_row && search->row < term->view_row + vga_rows - 1) return;
+
+    size_t view = (search->row > vga_rows / 2) ? search->row - vga_rows / 2 : 0;
+    size_t max = view_max(term);
+    term->view_row = (view < max) ? view : max;
+}
+
+/* Touches pendant une recherche : le motif s'edite a la fin, chaque changement repart de l'occurrence courante vers le
+   haut ; Up / Ctrl+F occurrence precedente, Down suivante, Entree garde la vue, Echap revient a la vue de depart */
+static void search_process_key(Terminal* term, const KeyEvent* event) {
+    Search* search = &term->search;
+    uint8_t c = event->ascii;
+
+    switch (event->key) {
+        case KEY_UP: search_find(search, &term->history, SEARCH_OLDER, 0); break;
+        case KEY_DOWN: search_find(search, &term->history, SEARCH_NEWER, 0); break;
+        case KEY_PAGE_UP: view_page_up(term); return;
+        case KEY_PAGE_DOWN: view_page_down(term); return;
+        default:
+            if (c == CTRL('f')) {
+                search_find(search, &term->history, SEARCH_OLDER, 0);
+            } else if (c == '\n' || c == 27) {
+                search->active = 0;
+                if (c == 27) term->view_row = search->origin_view;
+                mark_all_dirty(); // efface la surbrillance et la barre
+                return;
+            } else if (c == '\b') {
+                if (search->length == 0) return;
+                search->length--;
+                search_find(search, &term->history, SEARCH_OLDER, 1);
+            } else if (c >= ' ' && c != 0x7F && search->length < SEARCH_QUERY_MAX) {
+                search->query[search->length++] = (char) c;
+                search_find(search, &term->history, SEARCH_OLDER, 1);
+            } else {
+                return;
+            }
+    }
+    search_show(term);
+}
+
+/* --- Keyboard Handling --- */
+/* Applique un evenement du decodeur (modifie l'etat du terminal, le rendu est fait par l'appelant).
+   Une repetition typematique est traitee comme un nouvel appui */
+void terminal_process_key(const KeyEvent* event) {
+    if (event->flags & KEY_EVENT_RELEASE) return;
+    uint8_t key = event->key;
+
+    /* F1 a F10, F11, F12 : on switch d'ecran */
+    if (key >= KEY_F1 && key <= KEY_F10) { switch_screen(key - KEY_F1); return; }
+    if (key == KEY_F11 || key == KEY_F12) { switch_screen(key - KEY_F11 + 10); return; }
+
+    Terminal* term = active;
+
+    /* Ctrl+F : recherche dans l'historique, depuis la ligne du curseur vers le haut */
+    if (term->search.active) { search_process_key(term, event); return; }
+    if (event->ascii == CTRL('f')) { search_start(&term->search, term->row, vga_columns, term->view_row); return; }
+
+    LineEditor* line = &term->line;
+    size_t old_len = line_length(line);
+    size_t cursor = line_cursor(line);
+
+    switch (key) {
+        /* Deplacements dans la saisie : seul le curseur bouge */
+        case KEY_LEFT: if (line_left(line)) input_place_cursor(term); return;
+        case KEY_RIGHT: if (line_right(line)) input_place_cursor(term); return;
+        case KEY_HOME: line_move(line, 0); input_place_cursor(term); return;
+        case KEY_END: line_move(line, old_len); input_place_cursor(term); return;
+
+        /* Delete : le texte apres le curseur recule d'une case */
+        case KEY_DELETE: if (line_delete(line)) input_render(term, cursor, old_len); return;
+
+        /* Up / Down : rappel de l'historique des commandes, toute la saisie est redessinee */
+        case KEY_UP: if (line_history_prev(line)) input_render(term, 0, old_len); return;
+        case KEY_DOWN: if (line_history_next(line)) input_render(term, 0, old_len); return;
+
+        /* Page Up / Page Down : deplace uniquement la ligne de debut d'affichage */
+        case KEY_PAGE_UP: view_page_up(term); return;
+        case KEY_PAGE_DOWN: view_page_down(term); return;
+    }
+
+    /* Caractere produit par le layout */
+    uint8_t c = event->ascii;
+    if (c == '\n') {
+        input_submit(term);
+    } else if (c == '\b') {
+        /* Backspace : on ne peut pas effacer avant la limite read-only (debut de la saisie) */
+        if (line_backspace(line)) input_render(term, cursor - 1, old_len);
+    } else if (c >= ' ' && c != 0x7F) {
+        /* Les autres caracteres de controle (Tab, Echap, Ctrl+lettre) ne sont pas inseres */
+        if (line_insert(line, (char) c)) input_render(term, cursor, old_len);
+    }
+}
+
+/* Change la cellule du heartbeat et la recopie en VRAM si elle est visible */
+void terminal_set_heartbeat(uint16_t entry) {
+    heartbeat_cell = entry;
+    render_cell(0, vga_columns - 1);
+    vga_present();
+}
@@ -0,0 +1,96 @@
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ansi.h"
+#include "history.h"
+#include "keyboard.h"
+#include "line.h"
+#include "search.h"
+
+/* Compteurs de rendu (pour mesurer le trafic VRAM) */
+typedef struct {
+    uint32_t flushes;        // nombre d'appels a refresh_screen()
+    uint32_t cells_written;  // total de cellules recopiees en VRAM
+    uint32_t last_cells;     // cellules recopiees lors du dernier rendu
+    uint32_t max_cells;      // pire rendu observe
+    uint32_t cursor_writes;  // mises a jour reelles du curseur materiel
+} RenderStats;
+
+extern RenderStats render_stats;
+
+/* --- Ecrans virtuels --- */
+#define TERMINAL_MAX_SCREENS 12  // F1 a F12
+#define TERMINAL_MIN_HISTORY 100 // au moins la fenetre VRAM du mode panning (64 lignes) et une vue (VGA_MAX_ROWS)
+
+/* Attributs SGR qui ne tiennent pas dans l'attribut VGA */
+#define TERMINAL_SGR_BOLD    0x01 // premier plan clair
+#define TERMINAL_SGR_REVERSE 0x02 // premier plan et fond echanges dans color
+
+/* Un ecran virtuel. Tout son etat vit ici : le moteur ne garde qu'un pointeur sur l'ecran actif,
+   changer d'ecran ne recopie rien */
+typedef struct {
+    int index;               // 0 = F1 ... 11 = F12
+    size_t row;              // curseur (0 .. history_rows()-1)
+    size_t column;
+    size_t view_row;         // ligne haute visible (0 .. history_rows() - vga_rows)
+    uint8_t color;           // attribut courant (change par les sequences SGR)
+    uint8_t default_color;   // couleur de l'ecran (SGR 0)
+    uint8_t sgr;             // TERMINAL_SGR_* actifs
+    AnsiParser ansi;         // sequence d'echappement en cours (ansi.c)
+    size_t page_top;         // premiere ligne de la page (vga_rows lignes) adressee par les sequences (CUP, ED)
+    size_t saved_row;        // curseur sauve (ESC 7 / CSI s), ligne relative a page_top
+    size_t saved_column;
+    uint8_t saved_color;
+    uint8_t saved_sgr;
+    size_t input_start_row;  // debut de la saisie utilisateur, avant c'est read-only
+    size_t input_start_col;
+    LineEditor line;         // saisie en cours et historique des commandes (line.c)
+    Search search;           // recherche Ctrl+F en cours (search.c)
+    History history;         // lignes chaudes brutes + store froid compresse (history.c)
+    size_t lines;            // capacite de l'historique (lignes logiques)
+    int vram_slot;           // slot VRAM du mode panning (-1 : aucun, il est pris au prochain rendu)
+    int vram_top;            // ligne logique en tete du slot (peut etre < 0 apres des scrolls d'historique)
+    int vram_valid;          // 1 si le slot reflete la fenetre [vram_top, vram_top + VRAM_WINDOW_ROWS)
+    uint32_t last_shown;     // date du dernier affichage (eviction LRU des slots VRAM)
+} Terminal;
+
+/* Les ecrans sont alloues (et vides) au premier affichage avec l'allocateur donne a terminal_initialize().
+   Il retourne NULL s'il n'a plus de memoire : le moteur retente avec TERMINAL_MIN_HISTORY lignes, puis abandonne */
+typedef void* (*terminal_alloc_t)(size_t size);
+
+/* Octets alloues pour un ecran de lines lignes d'historique de columns cellules (vga_columns) : le Terminal (arrondi
+   a 16) puis son historique */
+#define TERMINAL_HEADER_SIZE ((sizeof(Terminal) + 15) & ~(size_t) 15)
+#define TERMINAL_STORAGE_SIZE(lines, columns) (TERMINAL_HEADER_SIZE + HISTORY_STORAGE_SIZE(lines, columns))
+
+/* Moteur du terminal (terminal.c) */
+/* lines : historique voulu par ecran (>= TERMINAL_MIN_HISTORY). Alloue et affiche l'ecran F1, les autres attendent */
+void terminal_initialize(size_t lines, terminal_alloc_t alloc);
+
+/* Ecran index (0 = F1), NULL s'il n'a jamais ete affiche */
+Terminal* terminal_get(int index);
+
+/* Ecran actuellement affiche (celui ou ecrivent terminal_write et printk) */
+Terminal* terminal_active(void);
+void terminal_write(const char* data, size_t size);
+void terminal_append(const char* data, size_t size);
+void terminal_writestring(const char* data);
+void refresh_screen(void);
+void terminal_set_panning(int enabled);
+void set_input_boundary(void);
+
+/* Affiche l'ecran screen_index (0 = F1), en l'allouant s'il n'existe pas encore. Retourne 0 s'il n'y a plus de memoire.
+   Le rendu est laisse a l'appelant */
+int switch_screen(int screen_index);
+
+/* Applique un evenement clavier (keyboard_decode) au terminal : edition (fleches, Home/End, Backspace/Delete),
+   rappel des commandes (Up/Down), F1-F12, Entree. Les relachements sont ignores. Le rendu est laisse a l'appelant */
+void terminal_process_key(const KeyEvent* event);
+
+/* Cellule (caractere + attribut) du heartbeat, affichee en haut a droite de l'historique (ligne 0, derniere colonne).
+   Elle est rendue tout de suite si elle est visible */
+void terminal_set_heartbeat(uint16_t entry);
+
+#endif
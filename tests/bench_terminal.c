@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fb.h"
+#include "host.h"
+#include "terminal.h"
+#include "vga.h"
+
+/* Benchmark du moteur du terminal sur l'hote : rejoue de gros flux de texte et de scancodes
+   et mesure le debit, le trafic VRAM (cellules recopiees par caractere) et le cout d'un scroll d'historique.
+   Chaque mesure est faite dans les deux modes de rendu (panning CRTC et copie de la vue), puis avec la console
+   framebuffer (vue de 128x48 dessinee dans un framebuffer 1024x768 en memoire a chaque rendu). */
+
+#define TEXT_CHARS (4 * 1024 * 1024)
+#define SCROLL_LINES 200000
+#define TYPED_COMMANDS 20000
+#define BOOTS 20000
+#define SEARCHES 2000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Generateur deterministe pour que deux executions rejouent le meme flux */
+static uint32_t lcg_state = 42;
+static uint32_t lcg_next(void) {
+    lcg_state = lcg_state * 1103515245u + 12345u;
+    return lcg_state >> 16;
+}
+
+/* Flux de lignes de 0 a 159 caracteres (certaines se replient), ecrit ligne par ligne comme le ferait printk */
+/* Demarrage du terminal : creation de F1 et premier rendu, jusqu'au premier caractere affiche */
+static void bench_boot(int panning) {
+    double start = now_seconds();
+    for (int i = 0; i < BOOTS; i++) {
+        host_reset(panning, HOST_MAX_HISTORY);
+        terminal_write("kfs> ", 5);
+        refresh_screen();
+    }
+    double elapsed = now_seconds() - start;
+
+    /* Lignes chaudes effectivement remplies : les autres ne sont initialisees qu'a leur premier usage */
+    const History* history = &terminal_active()->history;
+    printf("  boot     %8.2f us/boot    %3zu/%zu hot lines filled\n", elapsed / BOOTS * 1e6, history->hot_ready,
+           history->hot_lines);
+}
+
+static size_t text_stream(char* stream) {
+    size_t len = 0;
+
+    lcg_state = 42;
+    while (len < TEXT_CHARS) {
+        size_t line = lcg_next() % 160;
+        for (size_t i = 0; i < line && len < TEXT_CHARS - 1; i++) stream[len++] = (char) (' ' + lcg_next() % 95);
+        stream[len++] = '\n';
+    }
+    return len;
+}
+
+/* Ecrit le flux par lots de batch lignes (un rendu par lot), retourne la duree */
+static double write_lines(const char* stream, size_t len, int batch) {
+    double start = now_seconds();
+    size_t pos = 0;
+    while (pos < len) {
+        size_t end = pos;
+        for (int i = 0; i < batch && end < len; i++) {
+            while (stream[end] != '\n') end++;
+            end++;
+        }
+        terminal_write(&stream[pos], end - pos);
+        pos = end;
+    }
+    return now_seconds() - start;
+}
+
+static void bench_text(int panning) {
+    static char stream[TEXT_CHARS];
+    size_t len = text_stream(stream);
+
+    host_reset(panning, TERMINAL_MIN_HISTORY);
+    double elapsed = write_lines(stream, len, 1);
+
+    printf("  text     %8.2f Mchars/s  %6.2f cells/char  %7u flushes\n",
+           len / elapsed / 1e6, (double) render_stats.cells_written / len, render_stats.flushes);
+}
+
+/* Historique plein : chaque ligne recycle la plus ancienne. Un rendu par ligne.
+   Avec plus de HISTORY_HOT_LINES lignes, chaque ligne qui sort des lignes chaudes est compressee dans le store froid */
+static void bench_scroll(int panning, const char* name, size_t lines) {
+    static const char text[] = "scrolled line with some text\n";
+
+    host_reset(panning, lines);
+    for (size_t i = 0; i < lines + 100; i++) terminal_write(text, sizeof(text) - 1);
+    memset(&render_stats, 0, sizeof(render_stats));
+
+    double start = now_seconds();
+    for (int i = 0; i < SCROLL_LINES; i++) terminal_write(text, sizeof(text) - 1);
+    double elapsed = now_seconds() - start;
+
+    printf("  %-8s %8.1f ns/line   %6.2f cells/line\n",
+           name, elapsed / SCROLL_LINES * 1e9, (double) render_stats.cells_written / SCROLL_LINES);
+}
+
+/* Saisie interactive : une commande tapee, corrigee, puis Entree. Un rendu par scancode (pire cas) */
+static void bench_keyboard(int panning) {
+    static const char command[] = "echo hello wrld\b\b\borld\n";
+    size_t scancodes = 0;
+
+    host_reset(panning, TERMINAL_MIN_HISTORY);
+    terminal_write("kfs> ", 5);
+    set_input_boundary();
+
+    double start = now_seconds();
+    for (int i = 0; i < TYPED_COMMANDS; i++) {
+        host_type(command);
+        scancodes += 2 * (sizeof(command) - 1); // appui + relachement
+        terminal_write("kfs> ", 5);
+        set_input_boundary();
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("  keyboard %8.2f Mscan/s   %6.2f cells/scancode  %d commands\n",
+           scancodes / elapsed / 1e6, (double) render_stats.cells_written / scancodes, host_command_count);
+}
+
+/* Rafale (repetition typematique, collage) : la meme saisie arrive en un seul lot, un seul rendu par commande */
+static void bench_burst(int panning) {
+    static const uint8_t command[] = {
+        0x12, 0x2E, 0x23, 0x18, 0x39, 0x23, 0x12, 0x26, 0x26, 0x18, 0x39, 0x11, 0x13, 0x26, 0x20, // "echo hello wrld"
+        0x0E, 0x0E, 0x0E, 0x18, 0x13, 0x26, 0x20, 0x1C,                                           // "\b\b\borld\n"
+    };
+    uint8_t burst[2 * sizeof(command)];
+    for (size_t i = 0; i < sizeof(command); i++) {
+        burst[2 * i] = command[i];
+        burst[2 * i + 1] = (uint8_t) (command[i] | 0x80);
+    }
+
+    host_reset(panning, TERMINAL_MIN_HISTORY);
+    terminal_write("kfs> ", 5);
+    set_input_boundary();
+
+    double start = now_seconds();
+    for (int i = 0; i < TYPED_COMMANDS; i++) {
+        host_scancodes(burst, sizeof(burst));
+        terminal_write("kfs> ", 5);
+        set_input_boundary();
+    }
+    double elapsed = now_seconds() - start;
+    size_t scancodes = (size_t) TYPED_COMMANDS * sizeof(burst);
+
+    printf("  burst    %8.2f Mscan/s   %6.2f cells/scancode  %d commands\n",
+           scancodes / elapsed / 1e6, (double) render_stats.cells_written / scancodes, host_command_count);
+}
+
+/* Recherche Ctrl+F d'un motif absent dans un historique plein (lignes froides comprises) : chaque touche du motif
+   parcourt tout l'historique puis refait la vue. Un rendu par scancode comme bench_keyboard */
+static void bench_search(int panning) {
+    static const uint8_t round[] = {
+        0x1D, 0x21, 0xA1, 0x9D,  // Ctrl+F
+        0x2C, 0xAC, 0x10, 0x90,  // "zq"
+        0x01, 0x81,              // Echap
+    };
+    static const char text[] = "searched line with some text\n";
+
+    host_reset(panning, HOST_MAX_HISTORY);
+    for (size_t i = 0; i < HOST_MAX_HISTORY + 100; i++) terminal_write(text, sizeof(text) - 1);
+    memset(&render_stats, 0, sizeof(render_stats));
+
+    double start = now_seconds();
+    for (int i = 0; i < SEARCHES; i++) {
+        for (size_t k = 0; k < sizeof(round); k++) host_scancodes(&round[k], 1);
+    }
+    double elapsed = now_seconds() - start;
+
+    size_t rows = history_rows(&terminal_active()->history);
+    printf("  search   %8.2f us/key     %6.1f ns/line     %zu lines\n", elapsed / (SEARCHES * 2) * 1e6,
+           elapsed / (SEARCHES * 2) * 1e9 / (double) rows, rows);
+}
+
+/* --- Console framebuffer --- */
+#define FB_WIDTH 1024
+#define FB_HEIGHT 768
+
+static uint32_t fb_pixels[FB_WIDTH * FB_HEIGHT];
+
+static void fb_present(void) {
+    fb_draw(host_vram, host_crtc_read16(0x0C, 0x0D), host_crtc_read16(0x0E, 0x0F));
+}
+
+/* Terminal sur une vue de 128x48 dessinee a chaque rendu dans fb_pixels (format 0x00RRGGBB) */
+static void fb_reset(int panning, size_t lines) {
+    FbMode mode = {
+        .base = (uint8_t*) fb_pixels, .pitch = FB_WIDTH * 4, .width = FB_WIDTH, .height = FB_HEIGHT,
+        .red_position = 16, .red_size = 8, .green_position = 8, .green_size = 8, .blue_position = 0, .blue_size = 8,
+    };
+    vga_rows = fb_init(&mode, &vga_columns);
+    host_present = fb_present;
+    host_reset(panning, lines);
+    memset(&fb_stats, 0, sizeof(fb_stats));
+}
+
+/* Meme flux que bench_text : un rendu (et un dessin) par ligne, puis par lot de 32 lignes comme printk et
+   console_flush() (PERF_TEXT_BATCH). Chaque scroll redessine les cellules qui changent a leur position */
+static void bench_fb_text(int panning, const char* name, int batch) {
+    static char stream[TEXT_CHARS];
+    size_t len = text_stream(stream);
+
+    fb_reset(panning, TERMINAL_MIN_HISTORY);
+    double elapsed = write_lines(stream, len, batch);
+
+    printf("  %-8s %8.2f Mchars/s  %6.2f glyphs/char  %7u frames\n",
+           name, len / elapsed / 1e6, (double) fb_stats.glyphs / len, fb_stats.frames);
+}
+
+/* Saisie : seules les cellules de l'echo et du curseur sont redessinees */
+static void bench_fb_keyboard(int panning) {
+    static const char command[] = "echo hello wrld\b\b\borld\n";
+    size_t scancodes = 0;
+
+    fb_reset(panning, TERMINAL_MIN_HISTORY);
+    terminal_write("kfs> ", 5);
+    set_input_boundary();
+    memset(&fb_stats, 0, sizeof(fb_stats));
+
+    double start = now_seconds();
+    for (int i = 0; i < TYPED_COMMANDS / 10; i++) {
+        host_type(command);
+        scancodes += 2 * (sizeof(command) - 1);
+        terminal_write("kfs> ", 5);
+        set_input_boundary();
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("  keyboard %8.2f Mscan/s   %6.2f glyphs/scancode\n",
+           scancodes / elapsed / 1e6, (double) fb_stats.glyphs / scancodes);
+}
+
+int main(void) {
+    for (int panning = 1; panning >= 0; panning--) {
+        printf("%s mode:\n", panning ? "panning" : "copy");
+        bench_boot(panning);
+        bench_text(panning);
+        bench_scroll(panning, "scroll", TERMINAL_MIN_HISTORY);
+        bench_scroll(panning, "deep", HOST_MAX_HISTORY);
+        bench_keyboard(panning);
+        bench_burst(panning);
+        bench_search(panning);
+    }
+    for (int panning = 1; panning >= 0; panning--) {
+        printf("framebuffer %dx%d, %s mode:\n", FB_WIDTH, FB_HEIGHT, panning ? "panning" : "copy");
+        bench_fb_text(panning, "text", 1);
+        bench_fb_text(panning, "batch32", 32);
+        bench_fb_keyboard(panning);
+    }
+    host_present = NULL;
+    vga_rows = VGA_HEIGHT;
+    vga_columns = VGA_WIDTH;
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <string.h>
+#include "host.h"
+#include "terminal.h"
+#include "vga.h"
+
+/* --- Backend VGA --- */
+uint16_t host_vram[HOST_VRAM_CELLS];
+uint16_t* vga_buffer = host_vram;
+size_t vga_rows = VGA_HEIGHT;
+size_t vga_columns = VGA_WIDTH;
+void (*host_present)(void);
+
+static uint8_t crtc_registers[256];
+
+void vga_crtc_write16(uint8_t high_register, uint8_t low_register, uint16_t value) {
+    crtc_registers[low_register] = (uint8_t) (value & 0xFF);
+    crtc_registers[high_register] = (uint8_t) (value >> 8);
+}
+
+uint16_t host_crtc_read16(uint8_t high_register, uint8_t low_register) {
+    return (uint16_t) (crtc_registers[high_register] << 8 | crtc_registers[low_register]);
+}
+
+void vga_present(void) {
+    if (host_present) host_present();
+}
+
+/* --- Symboles du kernel utilises par terminal.c --- */
+/* memcpy / memmove / memset viennent de la libc de l'hote, memset16, memexpand16 et memfind16 n'existent que dans
+   string.c : versions scalaires ici, les vraies sont comparees a ces references par tests/test_string.c */
+void memset16(uint16_t* dst, uint16_t value, size_t count) {
+    for (size_t i = 0; i < count; i++) dst[i] = value;
+}
+
+void memexpand16(uint16_t* dst, const char* src, size_t count, uint16_t attribute) {
+    for (size_t i = 0; i < count; i++) dst[i] = (uint16_t) ((unsigned char) src[i] | attribute);
+}
+
+size_t memfind16(const uint16_t* cells, size_t count, const char* needle, size_t length) {
+    if (length == 0 || length > count) return count;
+    for (size_t i = 0; i + length <= count; i++) {
+        size_t k = 0;
+        while (k < length && (unsigned char) cells[i + k] == (unsigned char) needle[k]) k++;
+        if (k == length) return i;
+    }
+    return count;
+}
+
+char host_last_command[256];
+int host_command_count;
+
+/* La vraie commande ecrit dans le log ; ici la sortie va directement au terminal */
+void command_execute(const char* line) {
+    char output[300];
+    int len;
+
+    snprintf(host_last_command, sizeof(host_last_command), "%s", line);
+    host_command_count++;
+    len = snprintf(output, sizeof(output), "ran '%s'\n", line);
+    terminal_append(output, (size_t) len);
+}
+
+void console_flush(void) {
+}
+
+/* --- Harnais --- */
+/* Les ecrans sont alloues au premier affichage dans ce pool, vide a chaque host_reset() */
+static uint8_t history_pool[TERMINAL_MAX_SCREENS * TERMINAL_STORAGE_SIZE(HOST_MAX_HISTORY, VGA_MAX_COLUMNS)]
+    __attribute__((aligned(16)));
+static size_t history_pool_used;
+size_t host_pool_used(void) {
+    return history_pool_used;
+}
+
+size_t host_pool_limit = sizeof(history_pool);
+
+static void* host_alloc(size_t size) {
+    if (history_pool_used + size > host_pool_limit) return NULL;
+    void* block = &history_pool[history_pool_used];
+    history_pool_used = (history_pool_used + size + 15) & ~(size_t) 15; // blocs alignes sur 16 comme les pages du kernel
+    return block;
+}
+
+void host_reset(int panning, size_t lines) {
+    memset(host_vram, 0, sizeof(host_vram));
+    memset(crtc_registers, 0, sizeof(crtc_registers));
+    host_last_command[0] = '\0';
+    host_command_count = 0;
+    history_pool_used = 0;
+    host_pool_limit = sizeof(history_pool);
+    host_snapshot_attributes = 0;
+    keyboard_reset();
+    terminal_initialize(lines, host_alloc);
+    terminal_set_panning(panning);
+    memset(&render_stats, 0, sizeof(render_stats));
+}
+
+void host_scancodes(const uint8_t* bytes, size_t count) {
+    KeyEvent event;
+    for (size_t i = 0; i < count; i++) {
+        if (keyboard_decode(bytes[i], 0, &event)) terminal_process_key(&event);
+    }
+    refresh_screen();
+}
+
+void host_key(uint8_t key) {
+    uint8_t code = key & 0x7F;
+    if (key & 0x80) {
+        uint8_t bytes[] = { 0xE0, code, 0xE0, (uint8_t) (code | 0x80) };
+        host_scancodes(bytes, sizeof(bytes));
+        return;
+    }
+    uint8_t bytes[] = { code, (uint8_t) (code | 0x80) };
+    host_scancodes(bytes, sizeof(bytes));
+}
+
+void host_type(const char* text) {
+    const KeyboardLayout* layout = keyboard_layout();
+    for (; *text; text++) {
+        for (int code = 1; code < KEYMAP_SIZE; code++) {
+            if (layout->normal[code] == (unsigned char) *text) {
+                host_key((uint8_t) code);
+                break;
+            }
+            if (layout->shifted[code] == (unsigned char) *text) {
+                uint8_t bytes[] = { KEY_LSHIFT, (uint8_t) code, (uint8_t) (code | 0x80), KEY_LSHIFT | 0x80 };
+                host_scancodes(bytes, sizeof(bytes));
+                break;
+            }
+        }
+    }
+}
+
+int host_snapshot_attributes;
+
+void host_snapshot(char* out, size_t size) {
+    uint16_t start = host_crtc_read16(0x0C, 0x0D);
+    uint16_t cursor = host_crtc_read16(0x0E, 0x0F);
+    size_t len = 0;
+
+    if (cursor >= start && cursor < start + vga_columns * vga_rows) {
+        len += snprintf(out + len, size - len, "cursor %d,%d\n",
+                        (cursor - start) / (int) vga_columns, (cursor - start) % (int) vga_columns);
+    } else {
+        len += snprintf(out + len, size - len, "cursor hidden\n");
+    }
+    for (size_t y = 0; y < vga_rows; y++) {
+        char line[VGA_MAX_COLUMNS + 1];
+        for (size_t x = 0; x < vga_columns; x++) {
+            char c = (char) (host_vram[(start + y * vga_columns + x) % HOST_VRAM_CELLS] & 0xFF);
+            line[x] = c ? c : ' ';
+        }
+        line[vga_columns] = '\0';
+        len += snprintf(out + len, size - len, "|%s|\n", line);
+    }
+    if (!host_snapshot_attributes) return;
+
+    /* Attributs par ligne, en runs "attribut x nombre" pour rester lisible */
+    for (size_t y = 0; y < vga_rows; y++) {
+        const uint16_t* row = &host_vram[(start + y * vga_columns) % HOST_VRAM_CELLS];
+        len += snprintf(out + len, size - len, "%2zu:", y);
+        for (size_t x = 0; x < vga_columns;) {
+            size_t run = x + 1;
+            while (run < vga_columns && (row[run] >> 8) == (row[x] >> 8)) run++;
+            len += snprintf(out + len, size - len, " %02Xx%zu", row[x] >> 8, run - x);
+            x = run;
+        }
+        len += snprintf(out + len, size - len, "\n");
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Faux backend materiel pour compiler le moteur du terminal (terminal.c) sur l'hote Linux */
+
+#define HOST_VRAM_CELLS 32768 // comme la copie en RAM de la console framebuffer (VGA_SHADOW_CELLS)
+#define HOST_MAX_HISTORY 1000 // lignes d'historique par screen au plus pour host_reset()
+
+extern uint16_t host_vram[HOST_VRAM_CELLS];
+
+/* Derniere ligne recue par command_execute() et nombre d'appels */
+extern char host_last_command[256];
+extern int host_command_count;
+
+/* Pool ou les ecrans sont alloues : octets deja pris, et limite au-dela de laquelle l'allocation echoue
+   (remise a la taille du pool par host_reset) */
+size_t host_pool_used(void);
+extern size_t host_pool_limit;
+
+/* VRAM et registres CRTC a zero, compteurs remis a zero, terminal reinitialise dans le mode de rendu demande
+   avec lines lignes d'historique par screen (TERMINAL_MIN_HISTORY a HOST_MAX_HISTORY).
+   La vue fait vga_columns x vga_rows cellules (VGA_WIDTH x VGA_HEIGHT par defaut) : a changer avant host_reset() */
+void host_reset(int panning, size_t lines);
+
+/* Appelee par vga_present() apres chaque rendu si elle est mise (ex : dessin dans un framebuffer en memoire) */
+extern void (*host_present)(void);
+
+/* Valeur courante d'une paire de registres CRTC (ex : 0x0C/0x0D pour l'adresse de debut) */
+uint16_t host_crtc_read16(uint8_t high_register, uint8_t low_register);
+
+/* Fait passer des octets bruts (set 1, prefixes E0 compris) par le decodeur et le terminal puis fait un seul rendu,
+   comme un lot de keyboard_handler() */
+void host_scancodes(const uint8_t* bytes, size_t count);
+
+/* Envoie une touche KEY_* de keyboard.h (appui puis relachement, prefixe E0 si key & 0x80) puis fait le rendu */
+void host_key(uint8_t key);
+
+/* Tape une chaine avec le layout courant (Shift tenu pour les caracteres shiftes), un rendu par touche */
+void host_type(const char* text);
+
+/* Ce que l'ecran affiche vraiment : les vga_rows lignes lues en VRAM a partir de l'adresse de debut CRTC, et le curseur.
+   Si host_snapshot_attributes est mis (remis a 0 par host_reset), les attributs de chaque ligne suivent */
+extern int host_snapshot_attributes;
+void host_snapshot(char* out, size_t size);
+
+#endif
@@ -0,0 +1,107 @@
+#!/bin/sh
+# make perf : boote le kernel sous QEMU sans affichage avec "perf" en ligne de commande et affiche les cycles par
+# phase lus sur la console serie. make perf-check (PERF_CHECK=1) les compare en plus a la baseline et sort en erreur
+# si une phase a regresse de plus de PERF_TOLERANCE %.
+#
+#   tests/perf.sh [kfs.bin] [tests/perf_baseline.txt]
+#   QEMU=qemu-system-i386  PERF_TOLERANCE=25  PERF_TIMEOUT=300  UPDATE_BASELINE=1 (reecrit la baseline)
+#   PERF_CHECK=1 : compare a la baseline (sinon les mesures sont seulement affichees)
+#   PERF_ALLOW_NEW=1 : une phase absente de la baseline est signalee sans faire echouer (nouvelle phase a enregistrer)
+#
+# Erreurs de PERF_CHECK=1 : phase plus lente que la baseline + PERF_TOLERANCE %, phase sans baseline (sauf
+# PERF_ALLOW_NEW=1), phase de la baseline absente de la sortie serie (le kernel s'est arrete avant ou la phase a
+# disparu). Tant que tests/perf_baseline.txt n'a pas ete enregistree sous QEMU, toutes les phases sont sans baseline.
+#
+# -icount shift=0 : le TSC du guest avance avec les instructions executees (1 ns par instruction), les cycles
+# mesures ne dependent donc ni de la charge de la machine hote ni de son CPU.
+
+KERNEL=${1:-kfs.bin}
+BASELINE=${2:-tests/perf_baseline.txt}
+QEMU=${QEMU:-qemu-system-i386}
+TOLERANCE=${PERF_TOLERANCE:-25}
+
+if ! command -v "$QEMU" > /dev/null 2>&1; then
+    echo "perf: $QEMU not found" >&2
+    exit 2
+fi
+
+OUTPUT=$(mktemp)
+RESULTS=$(mktemp)
+trap 'rm -f "$OUTPUT" "$RESULTS"' EXIT
+
+timeout "${PERF_TIMEOUT:-300}" "$QEMU" -kernel "$KERNEL" -append perf -m 128M \
+    -display none -monitor none -serial stdio -no-reboot -icount shift=0 \
+    -device isa-debug-exit,iobase=0xf4,iosize=0x04 > "$OUTPUT" 2>&1
+status=$?
+
+# isa-debug-exit : le kernel ecrit 0, QEMU sort avec (0 << 1) | 1
+if [ "$status" -ne 1 ]; then
+    echo "perf: QEMU exited with status $status (124: timeout), serial output:" >&2
+    tail -n 20 "$OUTPUT" >&2
+    exit 1
+fi
+
+# "perf <phase> <unites> <cycles> cycles/<unite>". Les cycles vont jusqu'a 2^32 - 1 : affiches en %.0f, le %d de
+# mawk plafonne a 2^31 - 1
+tr -d '\r' < "$OUTPUT" | awk '$1 == "perf" && NF == 5 { print $2, $4, $5 }' > "$RESULTS"
+if [ ! -s "$RESULTS" ]; then
+    echo "perf: no results on the serial console" >&2
+    exit 1
+fi
+
+if [ -n "${UPDATE_BASELINE:-}" ]; then
+    {
+        echo "# Baseline de make perf : cycles par unite (QEMU -icount shift=0), une phase par ligne."
+        echo "# Regeneree par UPDATE_BASELINE=1 make perf, a relire dans le diff comme une golden."
+        cat "$RESULTS"
+    } > "$BASELINE"
+    echo "perf: baseline written to $BASELINE"
+    cat "$RESULTS"
+    exit 0
+fi
+
+if [ -z "${PERF_CHECK:-}" ]; then
+    awk '{ printf "  %-10s %10.0f %s\n", $1, $2, $3 }' "$RESULTS"
+    exit 0
+fi
+
+awk -v tolerance="$TOLERANCE" -v baseline="$BASELINE" -v allow_new="${PERF_ALLOW_NEW:-}" '
+    FNR == NR {
+        if ($0 !~ /^#/ && NF == 3) base[$1] = $2
+        next
+    }
+    {
+        seen[$1] = 1
+        if (!($1 in base)) {
+            printf "  %-10s %10s %10.0f %s  (no baseline)\n", $1, "-", $2, $3
+            missing++
+            next
+        }
+        delta = (base[$1] ? ($2 - base[$1]) * 100 / base[$1] : 0)
+        verdict = (delta > tolerance) ? "REGRESSION" : "ok"
+        if (delta > tolerance) failed++
+        printf "  %-10s %10.0f %10.0f %s  %+6.1f%%  %s\n", $1, base[$1], $2, $3, delta, verdict
+    }
+    END {
+        for (phase in base) {
+            if (!(phase in seen)) {
+                printf "  %-10s %10.0f %10s  (missing from the serial output)\n", phase, base[phase], "-"
+                absent++
+            }
+        }
+        status = 0
+        if (missing) {
+            printf "perf: %d phase(s) without baseline in %s, record them with UPDATE_BASELINE=1 make perf\n", missing, baseline
+            if (allow_new == "") status = 1
+        }
+        if (absent) {
+            printf "perf: %d baseline phase(s) not reported by the kernel\n", absent
+            status = 1
+        }
+        if (failed) {
+            printf "perf: %d phase(s) slower than baseline + %d%%\n", failed, tolerance
+            status = 1
+        }
+        exit status
+    }
+' "$BASELINE" "$RESULTS"
@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Tests des primitives memoire de string.c, compilees pour l'hote (x86-64, SSE2 toujours present).
+   string.c est inclus tel quel pour atteindre ses variantes static (rep movsd, SSE2, copie descendante) ; ses
+   fonctions publiques sont renommees pour ne pas remplacer celles de la libc dans tout le binaire.
+   Chaque variante est comparee a une boucle octet par octet, pour toutes les longueurs jusqu'a une borne et tous
+   les alignements de destination (et de source), avec des octets sentinelles autour de la zone ecrite. */
+#define memcpy kfs_memcpy
+#define memmove kfs_memmove
+#define memset kfs_memset
+#define strlen kfs_strlen
+#define strcmp kfs_strcmp
+#include "string.c"
+#undef memcpy
+#undef memmove
+#undef memset
+#undef strlen
+#undef strcmp
+
+/* string_benchmark() affiche avec printk, jamais appele ici */
+void printk(const char* format, ...) {
+    (void) format;
+}
+
+#define ARENA_SIZE 2048
+#define GUARD 0xA5
+
+static unsigned char arena[ARENA_SIZE] __attribute__((aligned(16)));
+static unsigned char expected[ARENA_SIZE] __attribute__((aligned(16)));
+static int failures;
+
+/* Remplissage deterministe (xorshift) : un octet decale ou oublie change le contenu compare */
+static uint32_t seed = 2463534242u;
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void fill_random(unsigned char* bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) bytes[i] = (unsigned char) next_random();
+}
+
+/* Compare arena a expected et signale le premier octet faux (un seul message par cas) */
+static int check(const char* name, size_t size, size_t offset) {
+    for (size_t i = 0; i < ARENA_SIZE; i++) {
+        if (arena[i] != expected[i]) {
+            printf("FAIL %s: size %zu, offset %zu: byte %zu is %02X, expected %02X\n", name, size, offset, i,
+                   arena[i], expected[i]);
+            failures++;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Apres une copie descendante le kernel compte sur DF = 0 (isr_common, rep des autres primitives) */
+static int direction_flag(void) {
+    unsigned long flags;
+    __asm__ volatile ("pushf\n\tpop %0" : "=r"(flags));
+    return (flags >> 10) & 1;
+}
+
+/* --- memcpy --- */
+typedef void* (*CopyFn)(void*, const void*, size_t);
+
+static void test_copy(const char* name, CopyFn copy, size_t max_size) {
+    for (size_t size = 0; size <= max_size; size++) {
+        for (size_t dst_offset = 0; dst_offset < 16; dst_offset++) {
+            for (size_t src_offset = 0; src_offset < 16; src_offset += 3) {
+                unsigned char* src = arena + 1024 + src_offset;
+                unsigned char* dst = arena + 16 + dst_offset;
+                memset(arena, GUARD, ARENA_SIZE);
+                fill_random(src, size);
+                memcpy(expected, arena, ARENA_SIZE);
+                for (size_t i = 0; i < size; i++) expected[16 + dst_offset + i] = src[i];
+
+                if (copy(dst, src, size) != dst) {
+                    printf("FAIL %s: size %zu: wrong return value\n", name, size);
+                    failures++;
+                    return;
+                }
+                if (!check(name, size, dst_offset)) return;
+            }
+        }
+    }
+}
+
+/* --- memmove avec recouvrement --- */
+/* dst = src + shift : shift > 0 recouvre vers le haut (copie descendante), shift < 0 vers le bas (copie montante) */
+static void test_overlap(const char* name, void (*move)(unsigned char*, const unsigned char*, size_t), int forward_only,
+                         int backward_only) {
+    static const int shifts[] = { -67, -16, -5, -4, -3, -1, 1, 2, 3, 4, 5, 15, 16, 17, 64, 67 };
+    /* Au-dela de SSE2_THRESHOLD memmove descendant passe par memcpy_sse2 avec recouvrement */
+    for (size_t size = 0; size <= 700; size++) {
+        for (size_t offset = 0; offset < 8; offset++) {
+            for (size_t s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+                int shift = shifts[s];
+                if ((forward_only && shift > 0) || (backward_only && shift < 0)) continue;
+                unsigned char* src = arena + 128 + offset;
+                unsigned char* dst = src + shift;
+                unsigned char saved[ARENA_SIZE];
+                fill_random(arena, ARENA_SIZE);
+                memcpy(saved, src, size);
+                memcpy(expected, arena, ARENA_SIZE);
+                memcpy(expected + (dst - arena), saved, size);
+
+                move(dst, src, size);
+                if (direction_flag()) {
+                    printf("FAIL %s: DF left set\n", name);
+                    failures++;
+                    __asm__ volatile ("cld");
+                    return;
+                }
+                if (!check(name, size, (size_t) (shift + 128))) return;
+            }
+        }
+    }
+}
+
+static void move_public(unsigned char* dst, const unsigned char* src, size_t size) {
+    kfs_memmove(dst, src, size);
+}
+
+/* --- memset32 / memset16 / memset --- */
+static void test_fill32(const char* name, void (*fill)(uint32_t*, uint32_t, size_t)) {
+    for (size_t count = 0; count <= 200; count++) {
+        for (size_t offset = 0; offset < 16; offset += 4) {
+            uint32_t value = next_random();
+            memset(arena, GUARD, ARENA_SIZE);
+            memcpy(expected, arena, ARENA_SIZE);
+            for (size_t i = 0; i < count; i++) memcpy(expected + 16 + offset + 4 * i, &value, 4);
+
+            fill((uint32_t*) (arena + 16 + offset), value, count);
+            if (!check(name, count, offset)) return;
+        }
+    }
+}
+
+static void test_fill16(void) {
+    for (size_t count = 0; count <= 300; count++) {
+        for (size_t offset = 0; offset < 16; offset += 2) {
+            uint16_t value = (uint16_t) next_random();
+            memset(arena, GUARD, ARENA_SIZE);
+            memcpy(expected, arena, ARENA_SIZE);
+            for (size_t i = 0; i < count; i++) memcpy(expected + 16 + offset + 2 * i, &value, 2);
+
+            memset16((uint16_t*) (arena + 16 + offset), value, count);
+            if (!check("memset16", count, offset)) return;
+        }
+    }
+}
+
+static void test_fill8(void) {
+    for (size_t size = 0; size <= 600; size++) {
+        for (size_t offset = 0; offset < 16; offset++) {
+            int value = (int) (next_random() & 0xFF);
+            memset(arena, GUARD, ARENA_SIZE);
+            memcpy(expected, arena, ARENA_SIZE);
+            memset(expected + 16 + offset, value, size);
+
+            kfs_memset(arena + 16 + offset, value, size);
+            if (!check("memset", size, offset)) return;
+        }
+    }
+}
+
+/* --- memexpand16 --- */
+typedef void (*ExpandFn)(uint16_t*, const unsigned char*, size_t, uint16_t);
+
+/* Reference : une cellule par octet, caractere dans l'octet bas, attribut dans l'octet haut */
+static void test_expand(const char* name, ExpandFn expand) {
+    for (size_t count = 0; count <= 200; count++) {
+        for (size_t dst_offset = 0; dst_offset < 16; dst_offset += 2) {
+            for (size_t src_offset = 0; src_offset < 16; src_offset++) {
+                const unsigned char* src = arena + 1024 + src_offset;
+                uint16_t attribute = (uint16_t) (next_random() << 8);
+                memset(arena, GUARD, ARENA_SIZE);
+                fill_random(arena + 1024, 512);
+                memcpy(expected, arena, ARENA_SIZE);
+                for (size_t i = 0; i < count; i++) {
+                    uint16_t cell = (uint16_t) (src[i] | attribute);
+                    memcpy(expected + 16 + dst_offset + 2 * i, &cell, 2);
+                }
+
+                expand((uint16_t*) (arena + 16 + dst_offset), src, count, attribute);
+                if (!check(name, count, dst_offset)) return;
+            }
+        }
+    }
+}
+
+static void expand_public(uint16_t* dst, const unsigned char* src, size_t count, uint16_t attribute) {
+    memexpand16(dst, (const char*) src, count, attribute);
+}
+
+/* --- memfind16 --- */
+/* La pile de cellules finit juste avant une page sans acces : une lecture apres la derniere cellule fait un SIGSEGV */
+#define FIND_MAX_CELLS 96
+static uint16_t* find_end;
+
+static void find_setup(void) {
+    long page = sysconf(_SC_PAGESIZE);
+    unsigned char* pages = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED || mprotect(pages + page, page, PROT_NONE)) {
+        perror("mmap");
+        exit(1);
+    }
+    find_end = (uint16_t*) (pages + page);
+}
+
+/* Alphabet de deux lettres : beaucoup de candidats dont le premier et le dernier caractere correspondent seuls.
+   Les attributs (octet haut) sont aleatoires, la recherche doit les ignorer */
+static void fill_cells(uint16_t* cells, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t r = next_random();
+        cells[i] = (uint16_t) (((r >> 8) & 0xFF00) | ('a' + (r & 1)));
+    }
+}
+
+static int find_compare(const uint16_t* cells, size_t count, const unsigned char* needle, size_t length) {
+    size_t want = memfind16_scalar(cells, count, needle, length, 0);
+    size_t got = memfind16_sse2(cells, count, needle, length);
+    size_t public = memfind16(cells, count, (const char*) needle, length);
+    if (got != want || public != want) {
+        printf("FAIL memfind16: count %zu, length %zu: sse2 %zu, memfind16 %zu, scalar %zu\n", count, length, got,
+               public, want);
+        failures++;
+        return 0;
+    }
+    return 1;
+}
+
+static void run_find(void) {
+    unsigned char needle[24];
+
+    for (size_t count = 1; count <= FIND_MAX_CELLS; count++) {
+        uint16_t* cells = find_end - count;
+        for (size_t length = 1; length <= 20 && length <= count; length++) {
+            /* Aiguille plantee a chaque position : les positions 8k - 1 .. 8k - length + 1 chevauchent deux blocs
+               de 16 octets, la derniere position finit sur la derniere cellule */
+            for (size_t at = 0; at + length <= count; at++) {
+                fill_cells(cells, count);
+                for (size_t i = 0; i < length; i++) needle[i] = (unsigned char) cells[at + i];
+                if (!find_compare(cells, count, needle, length)) return;
+            }
+
+            /* Aiguille absente (caractere hors alphabet), et seulement le dernier caractere faux */
+            fill_cells(cells, count);
+            for (size_t i = 0; i < length; i++) needle[i] = (unsigned char) cells[count - length + i];
+            needle[length - 1] = 'z';
+            if (!find_compare(cells, count, needle, length)) return;
+        }
+    }
+
+    /* Cellules moins nombreuses que l'aiguille, et aiguille vide : memfind16 rend count sans rien lire */
+    memset(needle, 'a', sizeof(needle));
+    for (size_t count = 0; count < 20; count++) {
+        uint16_t* cells = find_end - count;
+        for (size_t i = 0; i < count; i++) cells[i] = 'a';
+        size_t got = memfind16(cells, count, (const char*) needle, count + 1);
+        size_t empty = memfind16(cells, count, (const char*) needle, 0);
+        if (got != count || empty != count) {
+            printf("FAIL memfind16: count %zu: %zu for a longer needle, %zu for an empty one\n", count, got, empty);
+            failures++;
+            return;
+        }
+    }
+}
+
+/* --- Cas --- */
+static void run_fill32_sse2(void) { test_fill32("memset32_sse2", memset32_sse2); }
+static void run_fill32(void) { test_fill32("memset32", memset32); }
+static void run_copy_movsd(void) { test_copy("memcpy_movsd", memcpy_movsd, 300); }
+static void run_copy_sse2(void) { test_copy("memcpy_sse2", memcpy_sse2, 600); }
+static void run_copy(void) { test_copy("memcpy", kfs_memcpy, 600); }
+static void run_move_backward(void) { test_overlap("memmove_backward", memmove_backward, 0, 1); }
+static void run_move(void) { test_overlap("memmove", move_public, 0, 0); }
+static void run_expand_dwords(void) { test_expand("memexpand16_dwords", memexpand16_dwords); }
+static void run_expand_sse2(void) { test_expand("memexpand16_sse2", memexpand16_sse2); }
+static void run_expand(void) { test_expand("memexpand16", expand_public); }
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+} StringTest;
+
+static const StringTest tests[] = {
+    { "memcpy_movsd", run_copy_movsd },
+    { "memcpy_sse2", run_copy_sse2 },
+    { "memcpy", run_copy },
+    { "memmove_backward", run_move_backward },
+    { "memmove", run_move },
+    { "memset32_sse2", run_fill32_sse2 },
+    { "memset32", run_fill32 },
+    { "memset16", test_fill16 },
+    { "memset", test_fill8 },
+    { "memexpand16_dwords", run_expand_dwords },
+    { "memexpand16_sse2", run_expand_sse2 },
+    { "memexpand16", run_expand },
+    { "memfind16", run_find },
+};
+
+int main(void) {
+    int failed = 0;
+
+    find_setup();
+
+    /* Chaque cas passe deux fois : sans puis avec SSE2 (les fonctions publiques changent de chemin) */
+    for (int sse2 = 0; sse2 <= 1; sse2++) {
+        string_has_sse2 = sse2;
+        for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+            int before = failures;
+            tests[i].run();
+            if (failures != before) {
+                failed++;
+            } else {
+                printf("ok   %s%s\n", tests[i].name, sse2 ? " (sse2)" : "");
+            }
+        }
+    }
+
+    printf("%zu tests, %d failed\n", 2 * sizeof(tests) / sizeof(tests[0]), failed);
+    return failed ? 1 : 0;
+}
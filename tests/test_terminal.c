@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "terminal.h"
+#include "vga.h"
+
+/* Tests du moteur du terminal contre des snapshots de reference (tests/golden/<nom>.txt).
+   Chaque scenario est joue en mode panning puis en mode copie : les deux doivent afficher exactement la meme chose.
+   UPDATE_GOLDEN=1 ./tests/test_terminal tests/golden reecrit les references. */
+
+#define SNAPSHOT_SIZE 16384
+
+/* --- Touches --- */
+/* Les autres KEY_* viennent de keyboard.h (| 0x80 pour les codes prefixes E0) */
+#define KEY_F2 (KEY_F1 + 1)
+#define KEY_F3 (KEY_F1 + 2)
+#define KEY_LETTER_F 0x21 // make code de la lettre F
+
+static void write_str(const char* text) {
+    terminal_write(text, strlen(text));
+}
+
+/* Ctrl + touche, relachements compris */
+static void host_ctrl_key(uint8_t scancode) {
+    uint8_t bytes[] = { KEY_LCTRL, scancode, (uint8_t) (scancode | 0x80), KEY_LCTRL | 0x80 };
+    host_scancodes(bytes, sizeof(bytes));
+}
+
+static void prompt(void) {
+    write_str("kfs> ");
+    set_input_boundary();
+}
+
+/* --- Scenarios --- */
+static void test_banner(void) {
+    write_str("KFS-1 with Bonus 42\n");
+    write_str("--------------------------------\n");
+    write_str("Type something:\n");
+    prompt();
+}
+
+static void test_wrap(void) {
+    char line[200];
+    for (int i = 0; i < 200; i++) line[i] = (char) ('a' + i % 26);
+    terminal_write(line, sizeof(line));
+}
+
+/* Runs imprimables coupes par des octets de controle, lignes de 80 pile, runs qui debordent sur plusieurs lignes
+   et scroll au milieu d'un run : meme resultat que caractere par caractere */
+static void test_write_runs(void) {
+    char line[VGA_WIDTH + 1];
+    for (int i = 0; i < 30; i++) {
+        for (size_t c = 0; c < VGA_WIDTH; c++) line[c] = (char) ('A' + (i + c) % 26);
+        line[VGA_WIDTH] = '\n';
+        terminal_append(line, (i % 3 == 0) ? VGA_WIDTH + 1 : (size_t) (10 + i));
+    }
+    write_str("tab\tsoh\x01" "bell\a del\x7f high\x82\xDB|");
+    write_str("erase\b\b\bXY\n\b\bstart");
+    char wide[300];
+    for (int i = 0; i < 300; i++) wide[i] = (char) ('0' + i % 10);
+    terminal_write(wide, sizeof(wide));
+}
+
+static void test_backspace(void) {
+    prompt();
+    host_type("hello");
+    for (int i = 0; i < 7; i++) host_type("\b");
+    host_type("ok");
+}
+
+static void test_backspace_wrap(void) {
+    prompt();
+    for (int i = 0; i < 85; i++) host_type("x");
+    for (int i = 0; i < 10; i++) host_type("\b");
+}
+
+static void test_history_scroll(void) {
+    char line[32];
+    for (int i = 0; i < 150; i++) {
+        snprintf(line, sizeof(line), "line %03d\n", i);
+        write_str(line);
+    }
+    prompt();
+}
+
+static void test_page_up(void) {
+    test_history_scroll();
+    for (int i = 0; i < 90; i++) host_key(KEY_PAGE_UP);
+    host_key(KEY_PAGE_DOWN);
+}
+
+static void test_screens(void) {
+    write_str("first screen\n");
+    prompt();
+    host_key(KEY_F2);
+    write_str("second screen\n");
+    host_key(KEY_F3);
+    write_str("third screen\n");
+    host_key(KEY_F1);
+    host_type("back");
+}
+
+/* Scancode de la touche Fn (1..12) */
+static uint8_t function_key(int n) {
+    return (n <= 10) ? (uint8_t) (KEY_F1 + n - 1) : (uint8_t) (KEY_F11 + n - 11);
+}
+
+/* Les 12 ecrans sont ouverts : en mode panning il n'y a que 3 slots VRAM, F1 doit etre recopie en revenant */
+static void test_screens_all(void) {
+    char line[32];
+    write_str("screen 1\n");
+    prompt();
+    for (int n = 2; n <= 12; n++) {
+        host_key(function_key(n));
+        snprintf(line, sizeof(line), "screen %d\n", n);
+        write_str(line);
+    }
+    host_key(function_key(1));
+    host_type("back");
+}
+
+/* Plus de memoire apres F1 : F2 n'obtient que l'historique minimum, F3 ne peut pas etre ouvert */
+static void test_screens_no_memory(void) {
+    write_str("first screen\n");
+    host_pool_limit = host_pool_used() + TERMINAL_STORAGE_SIZE(TERMINAL_MIN_HISTORY, vga_columns);
+    host_key(KEY_F2);
+    write_str("second screen\n");
+    host_key(KEY_F3);
+    write_str("still second\n");
+    prompt();
+}
+
+static void test_arrows(void) {
+    prompt();
+    host_type("abcdef");
+    for (int i = 0; i < 3; i++) host_key(KEY_LEFT);
+    host_type("xy");
+    host_key(KEY_RIGHT);
+    host_key(KEY_UP);
+    host_key(KEY_DOWN);
+}
+
+/* Edition au milieu d'une saisie repliee sur deux lignes : Home, Delete, insertion, End, Backspace */
+static void test_line_edit(void) {
+    prompt();
+    for (int i = 0; i < 9; i++) host_type("0123456789");
+    host_key(KEY_HOME);
+    host_key(KEY_DELETE);
+    host_key(KEY_DELETE);
+    host_type("ab");
+    host_key(KEY_END);
+    for (int i = 0; i < 3; i++) host_key(KEY_LEFT);
+    host_type("\bz");
+    for (int i = 0; i < 300; i++) host_key(KEY_DELETE); // ne depasse pas la fin
+}
+
+/* Up / Down rappellent les commandes, le brouillon revient apres la plus recente */
+static void test_line_history(void) {
+    prompt();
+    host_type("first\n");
+    prompt();
+    host_type("second command that is long enough to wrap past the end of the first row of the screen\n");
+    prompt();
+    host_type("dra");
+    host_key(KEY_UP);
+    host_key(KEY_UP);
+    host_key(KEY_UP); // pas plus ancien que "first"
+    host_key(KEY_DOWN);
+    host_key(KEY_DOWN);
+    host_type("ft");
+    host_key(KEY_UP);
+    host_key(KEY_UP);
+    host_type(" again\n");
+    prompt();
+    host_key(KEY_UP);
+}
+
+/* Shift, Caps Lock, Ctrl, Num Lock, repetition typematique, touches E0 (et leurs faux Shift), Pause ignoree */
+static void test_keyboard_modifiers(void) {
+    prompt();
+    host_type("Hello, World! ");
+    host_key(KEY_CAPS_LOCK);
+    host_type("caps ");
+    uint8_t caps_shift[] = { 0x2A, 0x1E, 0x9E, 0xAA, 0x02, 0x82 }; // Shift+a = a et Shift+1 = ! sous Caps Lock
+    host_scancodes(caps_shift, sizeof(caps_shift));
+    host_key(KEY_CAPS_LOCK);
+    uint8_t repeat[] = { 0x2D, 0x2D, 0x2D, 0xAD };                 // x tenu : deux repetitions
+    host_scancodes(repeat, sizeof(repeat));
+    uint8_t ctrl_c[] = { 0x1D, 0x2E, 0xAE, 0x9D };                 // Ctrl+c n'insere rien
+    host_scancodes(ctrl_c, sizeof(ctrl_c));
+    uint8_t numpad[] = { 0x45, 0xC5, 0x4F, 0xCF, 0x50, 0xD0, 0x45, 0xC5 }; // 1 et 2 du pave avec Num Lock
+    host_scancodes(numpad, sizeof(numpad));
+    uint8_t pause[] = { 0xE1, 0x1D, 0x45, 0xE1, 0x9D, 0xC5 };      // ne bascule pas Num Lock
+    host_scancodes(pause, sizeof(pause));
+    uint8_t home[] = { 0xE0, 0x2A, 0xE0, 0x47, 0xE0, 0xC7, 0xE0, 0xAA }; // Home etendu entoure de faux Shift
+    host_scancodes(home, sizeof(home));
+    host_type(">");
+    uint8_t right[] = { 0xE0, 0x4D, 0xE0, 0xCD, 0x4D, 0xCD };      // fleche E0 puis 6 du pave sans Num Lock
+    host_scancodes(right, sizeof(right));
+    host_type("|");
+}
+
+/* AZERTY : memes positions physiques, autres caracteres (AltGr et code page 437 compris) */
+static void test_keyboard_layout(void) {
+    keyboard_set_layout("fr");
+    prompt();
+    uint8_t positions[] = { 0x10, 0x90, 0x11, 0x91, 0x02, 0x82, 0x03, 0x83, 0x39, 0xB9 }; // a z & e-aigu espace
+    host_scancodes(positions, sizeof(positions));
+    uint8_t altgr[] = { 0xE0, 0x38, 0x0B, 0x8B, 0x06, 0x86, 0xE0, 0xB8 };              // AltGr+0 = @, AltGr+5 = [
+    host_scancodes(altgr, sizeof(altgr));
+    host_type(" azerty AZERTY 1234 ;:!?./");
+    keyboard_set_layout("us");
+    host_type(" qwerty");
+}
+
+static void test_enter(void) {
+    prompt();
+    host_type("help\n");
+    prompt();
+    host_type("x");
+}
+
+static void test_heartbeat(void) {
+    test_banner();
+    terminal_set_heartbeat('|');
+}
+
+/* Historique de 300 lignes : les plus anciennes passent dans le store froid compresse, puis sont perdues par nombre */
+static void test_history_cold(void) {
+    char line[32];
+    for (int i = 0; i < 400; i++) {
+        snprintf(line, sizeof(line), "cold %03d\n", i);
+        write_str(line);
+    }
+    prompt();
+    for (int i = 0; i < 300; i++) host_key(KEY_PAGE_UP);
+    for (int i = 0; i < 2; i++) host_key(KEY_PAGE_DOWN);
+}
+
+/* Lignes pleines de 80 caracteres : le store froid est limite par ses octets, pas par son nombre de lignes */
+static void test_history_cold_full(void) {
+    char line[81];
+    for (int i = 0; i < 600; i++) {
+        for (int c = 0; c < 80; c++) line[c] = (char) ('A' + (i + c) % 26);
+        snprintf(line, sizeof(line), "%03d", i);
+        line[3] = ' ';
+        terminal_write(line, 80);
+    }
+    prompt();
+    host_type("abc");
+    for (int i = 0; i < 300; i++) host_key(KEY_PAGE_UP);
+}
+
+/* Sequences ANSI : couleurs SGR, CUP, EL / ED et sauvegarde du curseur, y compris coupees entre deux ecritures */
+static void test_ansi(void) {
+    host_snapshot_attributes = 1;
+    write_str("plain \033[31mred\033[0m \033[1;33;44mbold\033[m \033[7mreverse\033[27m \033[92;100mbright\033[39;49m\n");
+    write_str("split \033[");
+    write_str("32");
+    write_str("mgreen\033[0m \033[?25lprivate \033[Zunknown \033Xesc\n");
+    write_str("erase me to the end of this line\033[12D\033[K\n");
+    write_str("erase the start\033[5D\033[1K\n");
+    write_str("\033[10;20H\033[44mat 10,20\033[m\0337\033[1;70Hcorner\0338 back");
+    write_str("\033[3A up\033[2B\033[4C down\033[G\033[1mcol1\033[0m");
+    write_str("\033[20;1Hbelow\033[15;5H\033[J\033[99;3H*");
+}
+
+/* EL / ED sur la ligne en cours d'edition : le prompt s'efface, la saisie (apres la limite read-only) reste */
+static void test_ansi_input(void) {
+    host_snapshot_attributes = 1;
+    test_banner();
+    host_type("abc");
+    write_str("\033[2K");
+    host_type("d");
+    host_key(KEY_HOME);
+    write_str("\033[1;1H\033[J\033[31mX");
+}
+
+/* 400 lignes dans 300 lignes d'historique (dont 172 froides), une ligne "needle" toutes les 50 */
+static void search_history(void) {
+    char line[32];
+    for (int i = 0; i < 400; i++) {
+        snprintf(line, sizeof(line), (i % 50 == 7) ? "msg %03d needle needle\n" : "msg %03d\n", i);
+        write_str(line);
+    }
+    prompt();
+    host_type("ls");
+}
+
+/* Ctrl+F : le motif est cherche depuis le curseur vers le haut, Up remonte (jusque dans le store froid), Down redescend */
+static void test_search(void) {
+    host_snapshot_attributes = 1;
+    search_history();
+    host_ctrl_key(KEY_LETTER_F);
+    host_type("needl");
+    host_type("e");
+    for (int i = 0; i < 6; i++) host_key(KEY_UP);
+    host_key(KEY_DOWN);
+}
+
+/* Motif sans occurrence : la vue reste sur la derniere occurrence de son debut ("msg 2") et la barre l'indique */
+static void test_search_missing(void) {
+    host_snapshot_attributes = 1;
+    search_history();
+    host_ctrl_key(KEY_LETTER_F);
+    host_type("msg 2x");
+}
+
+/* Echap : retour a la vue de depart sans surbrillance, la saisie reprend ou elle etait */
+static void test_search_escape(void) {
+    host_snapshot_attributes = 1;
+    search_history();
+    host_ctrl_key(KEY_LETTER_F);
+    host_type("needle");
+    host_key(KEY_UP);
+    host_key(KEY_ESCAPE);
+    host_type("x");
+}
+
+/* Vue de 48 lignes (console framebuffer en 1024x768) : "msg 307" est centre sur la vue (msg 283 en haut), puis PageUp
+   recule d'une page de 48 lignes (msg 235 en haut). La barre reste sur la derniere ligne */
+static void test_tall_view(void) {
+    host_snapshot_attributes = 1;
+    search_history();
+    host_ctrl_key(KEY_LETTER_F);
+    host_type("needle");
+    host_key(KEY_UP);
+    host_key(KEY_UP);
+    host_key(KEY_PAGE_UP);
+}
+
+/* Vue de 128x48 (console framebuffer en 1024x768) : la sortie et la saisie se replient a 128 colonnes (Backspace
+   remonte sur la ligne precedente), la recherche trouve "needle" au-dela de la colonne 80 et le surligne */
+static void test_wide_view(void) {
+    char line[300];
+    host_snapshot_attributes = 1;
+    for (int i = 0; i < 300; i++) line[i] = (char) ('a' + i % 26);
+    terminal_write(line, sizeof(line));
+    write_str("\n");
+    for (int i = 0; i < 100; i++) write_str("-");
+    write_str(" needle past column 80\n");
+    prompt();
+    for (int i = 0; i < 13; i++) host_type("0123456789");
+    host_type("\b\b\b");
+    host_ctrl_key(KEY_LETTER_F);
+    host_type("needle");
+}
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+    size_t history_lines;
+    size_t rows;           // lignes de la vue (vga_rows)
+    size_t columns;        // colonnes de la vue (vga_columns)
+} TestCase;
+
+static const TestCase tests[] = {
+    { "banner", test_banner, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "wrap", test_wrap, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "write_runs", test_write_runs, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "backspace", test_backspace, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "backspace_wrap", test_backspace_wrap, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "history_scroll", test_history_scroll, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "page_up", test_page_up, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "screens", test_screens, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "screens_all", test_screens_all, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "screens_no_memory", test_screens_no_memory, 300, VGA_HEIGHT, VGA_WIDTH },
+    { "arrows", test_arrows, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "line_edit", test_line_edit, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "line_history", test_line_history, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "enter", test_enter, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "keyboard_modifiers", test_keyboard_modifiers, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "keyboard_layout", test_keyboard_layout, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "heartbeat", test_heartbeat, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "history_cold", test_history_cold, 300, VGA_HEIGHT, VGA_WIDTH },
+    { "history_cold_full", test_history_cold_full, 300, VGA_HEIGHT, VGA_WIDTH },
+    { "ansi", test_ansi, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "ansi_input", test_ansi_input, TERMINAL_MIN_HISTORY, VGA_HEIGHT, VGA_WIDTH },
+    { "search", test_search, 300, VGA_HEIGHT, VGA_WIDTH },
+    { "search_missing", test_search_missing, 300, VGA_HEIGHT, VGA_WIDTH },
+    { "search_escape", test_search_escape, 300, VGA_HEIGHT, VGA_WIDTH },
+    { "tall_view", test_tall_view, 300, 48, VGA_WIDTH },
+    { "wide_view", test_wide_view, 300, 48, 128 },
+};
+
+static int read_file(const char* path, char* out, size_t size) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    size_t len = fread(out, 1, size - 1, file);
+    out[len] = '\0';
+    fclose(file);
+    return 1;
+}
+
+static int write_file(const char* path, const char* data) {
+    FILE* file = fopen(path, "w");
+    if (!file) return 0;
+    fputs(data, file);
+    fclose(file);
+    return 1;
+}
+
+static void run_case(const TestCase* test, int panning, char* out) {
+    vga_rows = test->rows;
+    vga_columns = test->columns;
+    host_reset(panning, test->history_lines);
+    test->run();
+    host_snapshot(out, SNAPSHOT_SIZE);
+}
+
+int main(int argc, char** argv) {
+    const char* golden_dir = (argc > 1) ? argv[1] : "tests/golden";
+    int update = getenv("UPDATE_GOLDEN") != NULL;
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        char panned[SNAPSHOT_SIZE], copied[SNAPSHOT_SIZE], expected[SNAPSHOT_SIZE];
+        char path[512];
+
+        run_case(&tests[i], 1, panned);
+        run_case(&tests[i], 0, copied);
+        snprintf(path, sizeof(path), "%s/%s.txt", golden_dir, tests[i].name);
+
+        if (strcmp(panned, copied) != 0) {
+            printf("FAIL %s: panning and copy modes differ\n--- pan\n%s--- copy\n%s", tests[i].name, panned, copied);
+            failed++;
+        } else if (update) {
+            if (!write_file(path, panned)) {
+                printf("FAIL %s: cannot write %s\n", tests[i].name, path);
+                failed++;
+            } else {
+                printf("UPDATED %s\n", tests[i].name);
+            }
+        } else if (!read_file(path, expected, sizeof(expected))) {
+            printf("FAIL %s: missing %s (run with UPDATE_GOLDEN=1)\n", tests[i].name, path);
+            failed++;
+        } else if (strcmp(panned, expected) != 0) {
+            printf("FAIL %s: snapshot differs from %s\n--- got\n%s", tests[i].name, path, panned);
+            failed++;
+        } else {
+            printf("ok   %s\n", tests[i].name);
+        }
+    }
+
+    printf("%zu tests, %d failed\n", sizeof(tests) / sizeof(tests[0]), failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu.h"
+#include "idt.h"
+#include "io.h"
+#include "math64.h"
+#include "timer.h"
+
+/* --- Port mapping --- */
+static const uint16_t PIT_CHANNEL0 = 0x40; // Compteur du canal 0 (relie a l'IRQ0)
+static const uint16_t PIT_COMMAND  = 0x43; // Registre de mode/commande du PIT
+
+/* --- Constantes --- */
+static const uint32_t PIT_BASE_HZ = 1193182;  // Frequence d'entree du PIT
+static const uint8_t PIT_CH0_RATE_GENERATOR = 0x34; // canal 0, lobyte/hibyte, mode 2 (rate generator), binaire
+static const uint32_t CALIBRATION_TICKS = 5;  // 5 ticks = 50 ms de mesure
+
+volatile uint32_t timer_ticks = 0;
+uint32_t tsc_khz = 0;
+
+static int tsc_present;      // CPUID : rdtsc disponible
+static uint64_t tsc_origin;  // valeur du TSC a timer_init() (origine de uptime_ns)
+static uint64_t ns_per_cycle; // nanosecondes par cycle en virgule fixe 32.32
+
+static void timer_irq(InterruptFrame* frame) {
+    (void) frame;
+    timer_ticks++;
+}
+
+void timer_init(void) {
+    uint32_t divisor = PIT_BASE_HZ / TIMER_HZ;
+
+    outb(PIT_COMMAND, PIT_CH0_RATE_GENERATOR);
+    outb(PIT_CHANNEL0, (uint8_t) (divisor & 0xFF));
+    outb(PIT_CHANNEL0, (uint8_t) ((divisor >> 8) & 0xFF));
+
+    tsc_present = (cpuid_features_edx() & CPUID_EDX_TSC) != 0;
+    if (tsc_present) tsc_origin = rdtsc();
+    irq_register(0, timer_irq);
+}
+
+/* Attend le prochain front de tick (hlt : le CPU dort entre deux ticks) */
+static uint32_t wait_next_tick(void) {
+    uint32_t start = timer_ticks;
+    while (timer_ticks == start) __asm__ volatile ("hlt");
+    return timer_ticks;
+}
+
+void timer_calibrate_tsc(void) {
+    if (!(cpuid_features_edx() & CPUID_EDX_TSC)) return;
+
+    /* On se cale sur un front de tick puis on compte les cycles sur CALIBRATION_TICKS ticks */
+    uint32_t first = wait_next_tick();
+    uint64_t start = rdtsc();
+    while (timer_ticks - first < CALIBRATION_TICKS) __asm__ volatile ("hlt");
+    uint64_t cycles = rdtsc() - start;
+
+    /* cycles / (CALIBRATION_TICKS * 1000 / TIMER_HZ ms) = cycles par ms = kHz */
+    tsc_khz = (uint32_t) udiv64_32(cycles, CALIBRATION_TICKS * 1000 / TIMER_HZ, NULL);
+    if (tsc_khz == 0) return;
+
+    /* 10^6 ns par ms / tsc_khz cycles par ms, en 32.32 */
+    ns_per_cycle = udiv64_32(1000000ULL << 32, tsc_khz, NULL);
+}
+
+uint64_t timer_cycles(void) {
+    return tsc_present ? rdtsc() : 0;
+}
+
+uint64_t tsc_to_ns(uint64_t cycles) {
+    if (tsc_khz == 0) return 0;
+    return mul_u64_shr32(cycles, ns_per_cycle);
+}
+
+uint64_t uptime_ns(void) {
+    if (tsc_khz == 0) return (uint64_t) timer_ticks * (1000000000u / TIMER_HZ);
+    return tsc_to_ns(rdtsc() - tsc_origin);
+}
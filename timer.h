@@ -0,0 +1,30 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+/* Frequence de l'IRQ0 programmee dans le PIT (1 tick = 10 ms) */
+#define TIMER_HZ 100
+
+/* Ticks de l'IRQ0 depuis timer_init() */
+extern volatile uint32_t timer_ticks;
+
+/* Frequence du TSC mesuree contre le PIT (0 si pas de TSC ou pas encore calibre) */
+extern uint32_t tsc_khz;
+
+/* Programme le canal 0 du PIT a TIMER_HZ et branche l'IRQ0 */
+void timer_init(void);
+
+/* Mesure la frequence du TSC sur quelques ticks du PIT. Les interruptions doivent etre actives */
+void timer_calibrate_tsc(void);
+
+/* Temps monotone depuis la calibration, en nanosecondes (resolution TSC, ou tick PIT si pas de TSC) */
+uint64_t uptime_ns(void);
+
+/* TSC courant, 0 sans TSC (utilisable des timer_init(), y compris depuis une IRQ) */
+uint64_t timer_cycles(void);
+
+/* Convertit une duree en cycles TSC en nanosecondes (0 si le TSC n'est pas calibre) */
+uint64_t tsc_to_ns(uint64_t cycles);
+
+#endif
@@ -0,0 +1,81 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "idt.h"
+#include "math64.h"
+#include "string.h"
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+const char* const trace_site_names[TRACE_SITE_COUNT] = {
+    "putchar", "run", "refresh", "scroll", "cursor", "switch", "printk", "keyboard", "latency", "fb",
+};
+
+static TraceHistogram histograms[TRACE_SITE_COUNT];
+static TraceEvent events[TRACE_EVENTS];
+static uint32_t event_head; // prochain evenement a ecrire (croissant, modulo TRACE_EVENTS)
+
+/* Appele a la sortie de chaque bloc trace, y compris depuis une IRQ (printk) : section critique courte */
+void trace_record(TraceSite site, uint64_t start, uint64_t end) {
+    uint64_t elapsed = end - start;
+    uint32_t cycles = (elapsed > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t) elapsed;
+    uint32_t flags = irq_save();
+
+    TraceHistogram* histogram = &histograms[site];
+    if (histogram->count == 0 || cycles < histogram->min) histogram->min = cycles;
+    if (cycles > histogram->max) histogram->max = cycles;
+    histogram->count++;
+    histogram->total += cycles;
+    histogram->buckets[cycles ? 31 - __builtin_clz(cycles) : 0]++;
+
+    TraceEvent* event = &events[event_head % TRACE_EVENTS];
+    event->start = start;
+    event->cycles = cycles;
+    event->site = site;
+    event_head++;
+
+    irq_restore(flags);
+}
+
+void trace_snapshot(TraceSite site, TraceHistogram* out) {
+    uint32_t flags = irq_save();
+    *out = histograms[site];
+    irq_restore(flags);
+}
+
+size_t trace_events(TraceEvent* out, size_t max) {
+    uint32_t flags = irq_save();
+    uint32_t available = (event_head < TRACE_EVENTS) ? event_head : TRACE_EVENTS;
+    size_t count = (max < available) ? max : available;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = events[(event_head - count + i) % TRACE_EVENTS];
+    }
+    irq_restore(flags);
+    return count;
+}
+
+void trace_reset(void) {
+    uint32_t flags = irq_save();
+    memset(histograms, 0, sizeof(histograms));
+    event_head = 0;
+    irq_restore(flags);
+}
+
+uint32_t trace_percentile(const TraceHistogram* histogram, uint32_t percent) {
+    if (histogram->count == 0) return 0;
+
+    /* Rang du percentile (arrondi au dessus) : count * percent peut depasser 32 bits */
+    uint32_t rank = (uint32_t) udiv64_32((uint64_t) histogram->count * percent + 99, 100, NULL);
+    uint32_t seen = 0;
+    for (int b = 0; b < TRACE_BUCKETS; b++) {
+        seen += histogram->buckets[b];
+        if (seen < rank) continue;
+        uint32_t bound = (b == 31) ? 0xFFFFFFFFu : (2u << b) - 1;
+        if (bound > histogram->max) bound = histogram->max;
+        if (bound < histogram->min) bound = histogram->min;
+        return bound;
+    }
+    return histogram->max;
+}
+
+#endif
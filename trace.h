@@ -0,0 +1,86 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Instrumentation des chemins chauds au TSC.
+   TRACE_SCOPE(site) au debut d'un bloc mesure les cycles jusqu'a la sortie du bloc (return compris) et les range
+   dans l'histogramme log2 du site et dans un ring d'evenements de taille fixe.
+   Compile avec TRACE_ENABLED=0 (make TRACE=0), TRACE_SCOPE ne genere rien et trace.c est vide */
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+/* Points de trace */
+typedef enum {
+    TRACE_PUTCHAR,
+    TRACE_RUN,       // terminal_put_run : un run de caracteres imprimables ecrit d'un bloc
+    TRACE_REFRESH,
+    TRACE_SCROLL,
+    TRACE_CURSOR,
+    TRACE_SWITCH,
+    TRACE_PRINTK,
+    TRACE_KEYBOARD,  // keyboard_handler : du scancode lu au glyphe en VRAM
+    TRACE_LATENCY,   // appui : de la capture dans l'IRQ1 au glyphe en VRAM (attente dans le ring comprise)
+    TRACE_FB,        // fb_draw : cellules changees redessinees dans le framebuffer
+    TRACE_SITE_COUNT
+} TraceSite;
+
+#define TRACE_BUCKETS 32   // bucket b : [2^b, 2^(b+1)) cycles (le bucket 0 prend aussi 0)
+#define TRACE_EVENTS 1024  // evenements gardes dans le ring (16 KB)
+
+typedef struct {
+    uint32_t count;
+    uint32_t min, max;     // en cycles
+    uint64_t total;
+    uint32_t buckets[TRACE_BUCKETS];
+} TraceHistogram;
+
+typedef struct {
+    uint64_t start;        // TSC a l'entree du bloc
+    uint32_t cycles;       // duree (saturee a 2^32 - 1)
+    uint32_t site;
+} TraceEvent;
+
+#if TRACE_ENABLED
+
+#include "cpu.h"
+
+extern const char* const trace_site_names[TRACE_SITE_COUNT];
+
+void trace_record(TraceSite site, uint64_t start, uint64_t end);
+
+typedef struct {
+    TraceSite site;
+    uint64_t start;
+} TraceScope;
+
+static inline void trace_scope_end(TraceScope* scope) {
+    trace_record(scope->site, scope->start, rdtsc());
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(site) \
+    TraceScope TRACE_CONCAT(trace_scope_, __LINE__) __attribute__((cleanup(trace_scope_end))) = { (site), rdtsc() }
+
+/* Copie coherente de l'histogramme d'un site */
+void trace_snapshot(TraceSite site, TraceHistogram* out);
+
+/* Recopie les max evenements les plus recents (le plus ancien en premier). Retourne le nombre recopie */
+size_t trace_events(TraceEvent* out, size_t max);
+
+void trace_reset(void);
+
+/* Borne haute (en cycles) du percentile percent (1..100), a la precision du bucket, bornee par min/max */
+uint32_t trace_percentile(const TraceHistogram* histogram, uint32_t percent);
+
+#else
+
+#define TRACE_SCOPE(site) do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "fb.h"
+#include "io.h"
+#include "vga.h"
+
+/* --- Port mapping --- */
+static const uint16_t CURSOR_INDEX = 0x3D4; // Port index : On y ecris le numero de registre inerne qu'on veut modifier
+static const uint16_t CURSOR_DATA  = 0x3D5; // Port data : On ecrit la valeur qu'on veut mettre dans le registre selectionne par 0X3D4
+
+uint16_t* vga_buffer = (uint16_t*) 0xB8000;
+size_t vga_rows = VGA_HEIGHT;
+size_t vga_columns = VGA_WIDTH;
+
+/* --- Console framebuffer --- */
+/* La VRAM texte et les registres CRTC sont emules en RAM : le terminal les ecrit comme en mode texte (panning compris)
+   et vga_present() dessine la vue qu'ils decrivent */
+static const uint8_t CRTC_START_HIGH = 0x0C;
+static const uint8_t CRTC_START_LOW = 0x0D;
+static const uint8_t CRTC_CURSOR_HIGH = 0x0E;
+static const uint8_t CRTC_CURSOR_LOW = 0x0F;
+
+static int framebuffer = 0;
+static uint16_t shadow_vram[VGA_SHADOW_CELLS];
+static uint8_t shadow_crtc[256];
+
+static inline uint16_t shadow_crtc16(uint8_t high_register, uint8_t low_register) {
+    return (uint16_t) (shadow_crtc[high_register] << 8 | shadow_crtc[low_register]);
+}
+
+void vga_use_framebuffer(size_t columns, size_t rows) {
+    framebuffer = 1;
+    vga_buffer = shadow_vram;
+    vga_columns = columns;
+    vga_rows = rows;
+}
+
+void vga_present(void) {
+    if (!framebuffer) return;
+    fb_draw(shadow_vram, shadow_crtc16(CRTC_START_HIGH, CRTC_START_LOW), shadow_crtc16(CRTC_CURSOR_HIGH, CRTC_CURSOR_LOW));
+}
+
+void vga_crtc_write16(uint8_t high_register, uint8_t low_register, uint16_t value) {
+    if (framebuffer) {
+        shadow_crtc[low_register] = (uint8_t) (value & 0xFF);
+        shadow_crtc[high_register] = (uint8_t) (value >> 8);
+        return;
+    }
+    outb(CURSOR_INDEX, low_register);
+    outb(CURSOR_DATA, (uint8_t) (value & 0xFF));
+    outb(CURSOR_INDEX, high_register);
+    outb(CURSOR_DATA, (uint8_t) ((value >> 8) & 0xFF));
+}
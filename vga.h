@@ -0,0 +1,57 @@
+#ifndef VGA_H
+#define VGA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Backend materiel du mode texte VGA. Sur la machine : vga.c (VRAM en 0xB8000, CRTC sur 0x3D4/0x3D5, ou leur
+   copie en RAM dessinee par la console framebuffer), sur l'hote : tests/host.c (tableau en memoire, registres CRTC
+   enregistres) */
+
+static const size_t VGA_WIDTH = 80; // Largeur du terminal 80
+static const size_t VGA_HEIGHT = 25; // Hauteur du terminal 25 en mode texte
+
+/* Lignes affichees : VGA_HEIGHT en mode texte, plus avec la console framebuffer (48 en 1024x768).
+   La vue doit tenir dans la fenetre de 64 lignes du mode panning (terminal.c) */
+#define VGA_MAX_ROWS 60
+extern size_t vga_rows;
+
+/* Colonnes affichees (largeur des lignes du terminal) : VGA_WIDTH en mode texte, la largeur du mode avec la console
+   framebuffer (128 en 1024x768). Fixee avant terminal_initialize() */
+#define VGA_MAX_COLUMNS 128
+extern size_t vga_columns;
+
+/* VRAM texte : 16384 cellules (caractere + attribut). Sa copie en RAM pour la console framebuffer en a
+   VGA_SHADOW_CELLS : les 3 fenetres de 64 lignes du mode panning y tiennent aussi en VGA_MAX_COLUMNS colonnes */
+#define VGA_SHADOW_CELLS 32768
+extern uint16_t* vga_buffer;
+
+/* Ecrit une valeur 16-bit dans une paire de registres CRTC (ex : 0x0E/0x0F pour le curseur) */
+void vga_crtc_write16(uint8_t high_register, uint8_t low_register, uint16_t value);
+
+/* Appelee apres chaque rendu du terminal. En mode texte la VGA lit la VRAM elle-meme et il n'y a rien a faire,
+   avec la console framebuffer les cellules changees sont dessinees (fb.c) */
+void vga_present(void);
+
+/* Passe sur la console framebuffer (fb_init() deja fait) : vga_buffer et les registres CRTC deviennent une copie
+   en RAM, la vue fait columns x rows cellules */
+void vga_use_framebuffer(size_t columns, size_t rows);
+
+/* --- Couleur --- */
+enum vga_color {
+	VGA_COLOR_BLACK = 0, VGA_COLOR_BLUE = 1, VGA_COLOR_GREEN = 2, VGA_COLOR_CYAN = 3,
+	VGA_COLOR_RED = 4, VGA_COLOR_MAGENTA = 5, VGA_COLOR_BROWN = 6, VGA_COLOR_LIGHT_GREY = 7,
+	VGA_COLOR_DARK_GREY = 8, VGA_COLOR_LIGHT_BLUE = 9, VGA_COLOR_LIGHT_GREEN = 10,
+	VGA_COLOR_LIGHT_CYAN = 11, VGA_COLOR_LIGHT_RED = 12, VGA_COLOR_LIGHT_MAGENTA = 13,
+	VGA_COLOR_YELLOW = 14, VGA_COLOR_WHITE = 15,
+};
+
+static inline uint8_t vga_entry_color(enum vga_color fg, enum vga_color bg) {
+	return fg | bg << 4;
+}
+
+static inline uint16_t vga_entry(unsigned char uc, uint8_t color) {
+	return (uint16_t) uc | (uint16_t) color << 8;
+}
+
+#endif